@@ -0,0 +1,104 @@
+#include "image.h"
+#include "mem.h"
+#include <sys/stat.h>
+
+static exec_image_t *image_cache = NULL; // All images with at least one user
+
+exec_image_t *ImageAcquire(char *path, int fd, struct load_info *li) {
+    struct stat st;
+    if (fstat(fd, &st) < 0) {
+        TracePrintf(0, "ImageAcquire: Can't identify executable '%s', loading it privately.\n", path);
+        return NULL;
+    }
+    int text_pg1 = (li->t_vaddr - VMEM_1_BASE) >> PAGESHIFT;
+
+    for (exec_image_t *image = image_cache; image != NULL; image = image->next) {
+        if (image->dev == st.st_dev && image->ino == st.st_ino &&
+            image->mtime == st.st_mtime && image->size == st.st_size &&
+            image->text_pg1 == text_pg1 && image->text_npg == (int)li->t_npg &&
+            strcmp(image->path, path) == 0) {
+            image->users++;
+            TracePrintf(1, "ImageAcquire: Reusing cached image of '%s' (%d users).\n", path, image->users);
+            return image;
+        }
+    }
+
+    exec_image_t *image = malloc(sizeof(exec_image_t));
+    if (image == NULL) {
+        return NULL;
+    }
+    image->path = malloc(strlen(path) + 1);
+    image->text_pfns = malloc(sizeof(int) * (li->t_npg > 0 ? li->t_npg : 1));
+    if (image->path == NULL || image->text_pfns == NULL) {
+        free(image->path);
+        free(image->text_pfns);
+        free(image);
+        return NULL;
+    }
+    strcpy(image->path, path);
+    image->dev = st.st_dev;
+    image->ino = st.st_ino;
+    image->mtime = st.st_mtime;
+    image->size = st.st_size;
+    image->text_pg1 = text_pg1;
+    image->text_npg = li->t_npg;
+    for (int i = 0; i < image->text_npg; i++) {
+        image->text_pfns[i] = -1;
+    }
+    image->users = 1;
+    image->next = image_cache;
+    image_cache = image;
+    TracePrintf(1, "ImageAcquire: Caching new image of '%s' (%d text pages).\n", path, image->text_npg);
+    return image;
+}
+
+exec_image_t *ImageDup(exec_image_t *image) {
+    if (image != NULL) {
+        image->users++;
+    }
+    return image;
+}
+
+void ImageRelease(exec_image_t *image) {
+    if (image == NULL || --image->users > 0) {
+        return;
+    }
+
+    // Last user is gone: unlink it and let go of the text frames
+    exec_image_t **link = &image_cache;
+    while (*link != NULL && *link != image) {
+        link = &(*link)->next;
+    }
+    if (*link == image) {
+        *link = image->next;
+    }
+    for (int i = 0; i < image->text_npg; i++) {
+        if (image->text_pfns[i] != -1) {
+            freeFrame(image->text_pfns[i]);
+        }
+    }
+    TracePrintf(1, "ImageRelease: Dropped cached image of '%s'.\n", image->path);
+    free(image->text_pfns);
+    free(image->path);
+    free(image);
+}
+
+void ImagePublishTextPage(exec_image_t *image, int page, int pfn) {
+    if (image == NULL || page < 0 || page >= image->text_npg || image->text_pfns[page] != -1) {
+        return;
+    }
+    frameRef(pfn);
+    image->text_pfns[page] = pfn;
+}
+
+int ImageTextLoaded(exec_image_t *image) {
+    if (image == NULL) {
+        return 0;
+    }
+    for (int i = 0; i < image->text_npg; i++) {
+        if (image->text_pfns[i] == -1) {
+            return 0;
+        }
+    }
+    return 1;
+}
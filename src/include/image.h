@@ -0,0 +1,85 @@
+#ifndef IMAGE_H
+#define IMAGE_H
+
+#include <sys/types.h>
+#include "ykernel.h"
+#include "load_info.h"
+
+/*
+ * Executable image cache. Processes running the same executable (same path and same
+ * file on the host) map the same physical text frames read-only. The cache holds one
+ * reference on every text frame it knows about for as long as some process uses the image,
+ * so the frames go back to the free list once the last user unmaps them.
+ */
+typedef struct exec_image {
+    char *path;              /* path the image was opened with */
+    dev_t dev;               /* host file identity, so a rebuilt binary isn't mistaken for the cached one */
+    ino_t ino;
+    time_t mtime;
+    off_t size;
+    int text_pg1;            /* first region 1 page of the text segment */
+    int text_npg;            /* number of text pages */
+    int *text_pfns;          /* frame holding each text page, -1 while not loaded yet */
+    int users;               /* processes currently running this image */
+    struct exec_image *next;
+} exec_image_t;
+
+/**
+ * ======================== Description =======================
+ * @brief Finds the cached image for an executable, or creates an empty entry for it, and
+ *        registers the caller as one more user of it.
+ * ======================== Parameters ========================
+ * @param path (char *): Path the executable was opened with.
+ * @param fd (int): Open descriptor of the executable (used to identify the file).
+ * @param li (struct load_info *): Load info of the executable.
+ * ======================== Returns ===========================
+ * @returns Pointer to the image on success.
+ * @returns NULL if the file can't be identified or memory runs out (the caller just loads privately).
+ */
+exec_image_t *ImageAcquire(char *path, int fd, struct load_info *li);
+
+/**
+ * ======================== Description =======================
+ * @brief Registers one more user (e.g. a forked child) of an image the caller already holds.
+ * ======================== Parameters ========================
+ * @param image (exec_image_t *): The image, may be NULL.
+ * ======================== Returns ===========================
+ * @returns The same image.
+ */
+exec_image_t *ImageDup(exec_image_t *image);
+
+/**
+ * ======================== Description =======================
+ * @brief Drops one user of an image. The last user removes it from the cache and drops the
+ *        cache's reference on every text frame. Call it after unmapping the process's text.
+ * ======================== Parameters ========================
+ * @param image (exec_image_t *): The image, may be NULL.
+ * ======================== Returns ===========================
+ * @returns void
+ */
+void ImageRelease(exec_image_t *image);
+
+/**
+ * ======================== Description =======================
+ * @brief Records the frame holding a text page so later users can map it. The cache takes
+ *        its own reference on the frame.
+ * ======================== Parameters ========================
+ * @param image (exec_image_t *): The image.
+ * @param page (int): Index of the page within the text segment.
+ * @param pfn (int): Frame now holding the page contents.
+ * ======================== Returns ===========================
+ * @returns void
+ */
+void ImagePublishTextPage(exec_image_t *image, int page, int pfn);
+
+/**
+ * ======================== Description =======================
+ * @brief Checks whether every text page of an image is already in memory.
+ * ======================== Parameters ========================
+ * @param image (exec_image_t *): The image, may be NULL.
+ * ======================== Returns ===========================
+ * @returns 1 if all text pages are loaded, 0 otherwise.
+ */
+int ImageTextLoaded(exec_image_t *image);
+
+#endif
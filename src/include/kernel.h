@@ -13,11 +13,27 @@
 #define KSTACK_START_PAGE (KERNEL_STACK_BASE >> PAGESHIFT)
 
 extern int kernel_brk_page;
+extern int is_vm_enabled;
 extern int text_section_base_page;
 extern int data_section_base_page;
 
+/* Kernel boot options (see ParseKernelOptions) */
+extern int lazy_load_enabled; /* "lazy=1": LoadProgram maps text and data pages on first touch */
+
 void KernelStart(char *cmd_args[], unsigned int pmem_size, UserContext *uctxt);
 
+/**
+ * ======================== Description =======================
+ * @brief Consumes the kernel boot options at the front of the command line. Options are
+ *        leading "name=value" arguments; the first argument without an '=' is the init program.
+ * ======================== Parameters ========================
+ * @param cmd_args (char **): NULL terminated command line passed to KernelStart.
+ * ======================== Returns ===========================
+ * @returns Pointer to the first non-option argument (the init program and its arguments).
+ * 
+*/
+char **ParseKernelOptions(char **cmd_args);
+
 /**
  * ======================== Description =======================
  * @brief Adjusts the kernel break (end of the kernel heap) to the specified address.
@@ -102,4 +118,18 @@ KernelContext *KCCopy(KernelContext *kc_in, void *new_pcb_p, void *unused);
 
 int LoadProgram(char *name, char *args[], PCB *proc);
 
+/**
+ * ======================== Description =======================
+ * @brief Fills a demand-paged (PAGE_LAZY) region 1 page on first touch. A frame is allocated and mapped,
+ *        the page is read from the process's executable (or zero-filled), and then it is given its final
+ *        protection.
+ * ======================== Parameters ========================
+ * @param proc (PCB *): The faulting process (must be the current process, its region 1 table is live).
+ * @param vpn (int): The region 1 virtual page number to load.
+ * ======================== Returns ===========================
+ * @returns SUCCESS if the page is now mapped.
+ * @returns ERROR if the page is not lazy, no frame is available or the executable can't be read.
+ */
+int LoadLazyPage(PCB *proc, int vpn);
+
 #endif
@@ -6,9 +6,14 @@
 #include "kernel.h"
 
 
-// #define SCRATCH_ADDR (KERNEL_STACK_BASE - PAGESIZE)
-#define SCRATCH_ADDR_DST (KERNEL_STACK_BASE - PAGESIZE) // e.g., 0xFA000
-#define SCRATCH_ADDR_SRC (KERNEL_STACK_BASE - (PAGESIZE*2)) // e.g., 0xF8000
+// Scratch window reserved right below the kernel stack for copying frames. It holds
+// SCRATCH_PAIRS (src, dst) page pairs; src pages are even slots and dst pages odd slots.
+// CloneFrames, ReadFrame, WriteFrame, ZeroFrame and CopyToProcess all share it and each one
+// unmaps what it mapped before returning, so the window never points at a frame outside a copy.
+#define SCRATCH_PAIRS 4
+#define SCRATCH_WINDOW_BASE (KERNEL_STACK_BASE - (2 * SCRATCH_PAIRS * PAGESIZE)) // e.g., 0xEC000
+#define SCRATCH_ADDR_SRC(i) (SCRATCH_WINDOW_BASE + (2 * (i)) * PAGESIZE)
+#define SCRATCH_ADDR_DST(i) (SCRATCH_WINDOW_BASE + (2 * (i) + 1) * PAGESIZE)
 
 typedef enum {
     FRAME_FREE = 0,
@@ -21,19 +26,46 @@ typedef struct frame_desc {
     unsigned int pfn;        /* physical frame number */
     frame_usage_t usage;     /* usage type */
     int owner_pid;           /* owning pid if usage == FRAME_USER (or -1) */
-    unsigned int last_used_tick; /* for eviction heuristics if needed */
+    int refcount;            /* number of page table entries mapping this frame */
+    unsigned int last_used_tick; /* tick at which the frame was last handed out or shared */
+    int referenced;          /* second-chance bit for the swap clock, set whenever the frame is (re)used */
+    int next_free;           /* next pfn on the free frame list (-1 if none) */
+    int prev_free;           /* previous pfn on the free frame list (-1 if none) */
+    int zeroed;              /* free frame sitting on the pre-zeroed pool instead of the plain free list */
+    int pinned;              /* > 0 while the kernel is copying to or from the frame; the swapper leaves it alone */
 } frame_desc_t;
 
+// How many pre-zeroed frames the idle process keeps around, and how many it zeroes per idle clock tick
+#define ZERO_POOL_TARGET 16
+#define ZERO_FRAMES_PER_IDLE_TICK 4
+
 extern frame_desc_t *frame_table;   /* allocated during InitMemory */
 extern int nframes;        /* number of frames available */
 extern int free_nframes;
+extern int free_frame_head; /* pfn at the head of the free frame list (-1 if empty) */
+extern int zeroed_frame_head; /* pfn at the head of the pre-zeroed pool (-1 if empty) */
+extern int zeroed_nframes;    /* frames on the pre-zeroed pool (also counted in free_nframes) */
+extern unsigned int zero_pool_hits;   /* allocZeroedFrame() calls served from the pool */
+extern unsigned int zero_pool_misses; /* allocZeroedFrame() calls that had to zero inline */
 
 // Kernel region 0 page table
 extern pte_t pt_region0[MAX_PT_LEN];
 
 /**
  * ======================== Description =======================
- * @brief Iterates through the free frames list, finds the first free frame, marks its usage with usage, and returns
+ * @brief Pushes a frame onto the head of the free frame list. Does not touch the frame's usage or free_nframes.
+ *        Only meant for building the list during boot and for freeFrame().
+ * ======================== Parameters ========================
+ * @param pfn (int): The physical frame number to link into the free list.
+ * ======================== returns ==========================
+ * @returns Nothing
+ * 
+*/
+void freeListPush(int pfn);
+
+/**
+ * ======================== Description =======================
+ * @brief Pops the frame at the head of the free frame list in O(1), marks its usage with usage, and returns
  *        the physical frame number (pfn).
  * ======================== Parameters ========================
  * @param usage (frame_usage_t): The usage we want to set to the frame we are allocating.
@@ -45,7 +77,46 @@ int allocFrame(frame_usage_t usage, int owner_pid);
 
 /**
  * ======================== Description =======================
- * @brief Tries to allocate a specific frame number.
+ * @brief Same as allocFrame(), but when memory is exhausted it swaps out other processes' pages until a
+ *        frame frees up. May block, so only call it from process context (syscalls, memory traps), never
+ *        from interrupt handlers or a KernelContextSwitch callback.
+ * ======================== Parameters ========================
+ * @param usage (frame_usage_t): The usage we want to set to the frame we are allocating.
+ * @param owner_pid (int): The owning pid.
+ * ======================== returns ==========================
+ * @returns pfn (int) on success, -1 if no frame could be freed.
+ * 
+*/
+int allocFrameEvict(frame_usage_t usage, int owner_pid);
+
+/**
+ * ======================== Description =======================
+ * @brief Allocates a zero-filled frame, preferring the pool zeroed by the idle process. When the pool is
+ *        empty it falls back to allocFrameEvict() and zeroes the frame inline, so it may block.
+ * ======================== Parameters ========================
+ * @param usage (frame_usage_t): The usage we want to set to the frame we are allocating.
+ * @param owner_pid (int): The owning pid.
+ * ======================== returns ==========================
+ * @returns pfn (int) of a zeroed frame on success, -1 if no frame could be found.
+ * 
+*/
+int allocZeroedFrame(frame_usage_t usage, int owner_pid);
+
+/**
+ * ======================== Description =======================
+ * @brief Moves up to budget frames from the free list to the pre-zeroed pool, zeroing each one, until
+ *        the pool holds ZERO_POOL_TARGET frames. Called from the clock trap while the idle process runs.
+ * ======================== Parameters ========================
+ * @param budget (int): Maximum number of frames to zero in this call.
+ * ======================== returns ==========================
+ * @returns Nothing
+ * 
+*/
+void RefillZeroPool(int budget);
+
+/**
+ * ======================== Description =======================
+ * @brief Tries to allocate a specific frame number. The frame is unlinked from the free list in O(1).
  * ======================== Parameters ========================
  * @param pfn (int): The physical frame number we want to allocate.
  * @param usage (frame_usage_t): The usage we want to set to the frame we are allocating.
@@ -57,7 +128,8 @@ int allocSpecificFrame(int pfn, frame_usage_t usage, int owner_pid);
 
 /**
  * ======================== Description =======================
- * @brief Frees a specific frame
+ * @brief Drops one reference to a frame. When the last reference goes away the frame is pushed back onto the
+ *        head of the free list. Freeing a frame that is already free is ignored so free_nframes stays exact.
  * ======================== Parameters ========================
  * @param pfn (int): The physical frame number we want to free.
  * ======================== returns ==========================
@@ -66,6 +138,17 @@ int allocSpecificFrame(int pfn, frame_usage_t usage, int owner_pid);
 */
 void freeFrame(int pfn);
 
+/**
+ * ======================== Description =======================
+ * @brief Takes an extra reference on an allocated frame, e.g. when a page is shared between parent and child.
+ * ======================== Parameters ========================
+ * @param pfn (int): The physical frame number being shared.
+ * ======================== returns ==========================
+ * @returns Nothing
+ * 
+*/
+void frameRef(int pfn);
+
 /**
  * ======================== Description =======================
  * @brief Maps a virtual page number (vpn) to a physical frame number (pfn) in the given page table (ptbr),
@@ -126,8 +209,193 @@ void MapRegion0(unsigned int vpn, int pfn);
  * 
 */
 void UnmapRegion0(unsigned int vpn);
+/**
+ * ======================== Description =======================
+ * @brief Copies a whole frame into / out of a kernel buffer through the scratch window. Used to move pages
+ *        of processes that aren't running (and so aren't mapped in region 1) to and from the disk.
+ * ======================== Parameters ========================
+ * @param pfn (int): The frame.
+ * @param buf (void *): Region 0 buffer of PAGESIZE bytes.
+ * ======================== Returns ===========================
+ * @returns Nothing.
+ * 
+*/
+void ReadFrame(int pfn, void *buf);
+void WriteFrame(int pfn, void *buf);
+
+/**
+ * ======================== Description =======================
+ * @brief Fills a physical frame with zeroes through the scratch window.
+ * ======================== Parameters ========================
+ * @param pfn (int): The frame to clear.
+ * ======================== returns ==========================
+ * @returns Nothing
+ * 
+*/
+void ZeroFrame(int pfn);
+
+/* One page copy for CloneFrames() */
+typedef struct frame_copy {
+    int pfn_src;
+    int pfn_dst;
+} frame_copy_t;
+
+/**
+ * ======================== Description =======================
+ * @brief Copies the contents of a list of frames into another list of frames through the scratch window.
+ *        Up to SCRATCH_PAIRS pairs are mapped at a time: all of a batch's PTEs are written first and
+ *        the TLB is flushed once per batch rather than once per page. The window is unmapped again
+ *        (one more flush) after the last batch.
+ * ======================== Parameters ========================
+ * @param copies (frame_copy_t *): The (src, dst) frame pairs to copy.
+ * @param n (int): Number of pairs.
+ * ======================== Returns ===========================
+ * @returns Nothing.
+ * 
+*/
+void CloneFrames(frame_copy_t *copies, int n);
+
+/**
+ * ======================== Description =======================
+ * @brief Copies kernel data into another process's region 1 buffer by mapping its frames, one
+ *        page at a time, through the scratch window. Never blocks, so it can be used from a trap
+ *        handler, so it doesn't bring anything in either.
+ * ======================== Parameters ========================
+ * @param proc (PCB *): The process owning the buffer.
+ * @param addr (void *): Start of the buffer in proc's region 1.
+ * @param src (void *): The data to copy.
+ * @param len (int): Number of bytes.
+ * ======================== Returns ===========================
+ * @returns SUCCESS, or ERROR (having copied nothing) if a page of the buffer isn't resident,
+ *          writable and private right now.
+ * 
+*/
+int CopyToProcess(PCB *proc, void *addr, void *src, int len);
+
+/**
+ * ======================== Description =======================
+ * @brief Copies a single frame, see CloneFrames().
+ * ======================== Parameters ========================
+ * @param pfn_src (int): Frame to copy from.
+ * @param pfn_dst (int): Frame to copy into.
+ * ======================== Returns ===========================
+ * @returns Nothing.
+ * 
+*/
 void CloneFrame(int pfn_src, int pfn_dst);
+
+/**
+ * ======================== Description =======================
+ * @brief Throws away a process's whole region 1: drops every mapped frame (shared frames only go free with
+ *        their last user), frees swap slots, clears the page flags, and lets go of the executable image.
+ *        Used by LoadProgram before building the new image and by Exit.
+ * ======================== Parameters ========================
+ * @param proc (PCB *): The process whose address space goes away.
+ * ======================== returns ==========================
+ * @returns Nothing
+ * 
+*/
+void FreeRegion1(PCB *proc);
+
+/**
+ * ======================== Description =======================
+ * @brief Shares every valid region 1 page of src with dst. Writable pages are downgraded to read-only in
+ *        both page tables and marked PAGE_COW, so the first write from either side faults and is resolved
+ *        by BreakCOW(). Each shared frame gains one reference.
+ * ======================== Parameters ========================
+ * @param src (PCB *): The process being forked (must be the current process).
+ * @param dst (PCB *): The child process receiving the mappings.
+ * ======================== Returns ===========================
+ * @returns SUCCESS.
+ * 
+*/
 int CopyPT(PCB *src, PCB *dst);
 
+/**
+ * ======================== Description =======================
+ * @brief Gives a process a private, writable copy of a copy-on-write page. If the process holds the only
+ *        reference to the frame it simply gets write permission back, otherwise the frame is cloned.
+ * ======================== Parameters ========================
+ * @param proc (PCB *): The process that owns the page table (must be the current process).
+ * @param vpn (int): The region 1 virtual page number that was written.
+ * ======================== Returns ===========================
+ * @returns SUCCESS on success.
+ * @returns ERROR if the page is not copy-on-write or no frame is available for the copy.
+ * 
+*/
+int BreakCOW(PCB *proc, int vpn);
+
+/**
+ * ======================== Description =======================
+ * @brief Breaks copy-on-write sharing on every page of a user buffer the kernel is about to write into,
+ *        since a write from kernel mode would otherwise fault on the read-only mapping. Demand-paged
+ *        pages in the buffer are loaded first.
+ * ======================== Parameters ========================
+ * @param proc (PCB *): The process owning the buffer (must be the current process).
+ * @param addr (void *): Start of the user buffer in region 1.
+ * @param len (int): Length of the buffer in bytes.
+ * ======================== Returns ===========================
+ * @returns SUCCESS on success, ERROR if a page could not be copied.
+ * 
+*/
+int PrepareUserWrite(PCB *proc, void *addr, int len);
+
+/**
+ * ======================== Description =======================
+ * @brief Loads any demand-paged (PAGE_LAZY) pages of a user buffer the kernel is about to read from.
+ * ======================== Parameters ========================
+ * @param proc (PCB *): The process owning the buffer (must be the current process).
+ * @param addr (void *): Start of the user buffer in region 1.
+ * @param len (int): Length of the buffer in bytes.
+ * ======================== Returns ===========================
+ * @returns SUCCESS on success, ERROR if a page could not be loaded.
+ * 
+*/
+int PrepareUserRead(PCB *proc, void *addr, int len);
+
+/**
+ * ======================== Description =======================
+ * @brief Same as PrepareUserRead() for a NUL terminated user string of unknown length. Also checks that
+ *        every page the string touches is mapped.
+ * ======================== Parameters ========================
+ * @param proc (PCB *): The process owning the string (must be the current process).
+ * @param str (char *): The user string.
+ * ======================== Returns ===========================
+ * @returns SUCCESS if the whole string is readable, ERROR otherwise.
+ * 
+*/
+int PrepareUserString(PCB *proc, char *str);
+
+/**
+ * ======================== Description =======================
+ * @brief Makes a user buffer resident (see PrepareUserRead()/PrepareUserWrite()) and pins the frames
+ *        backing it so the swapper can't take them while the kernel copies. Each page is pinned as
+ *        soon as it is in, so bringing in a later page can't push out an earlier one. May block on
+ *        swap I/O. Hold the pins only around the copy, never across a sleep.
+ * ======================== Parameters ========================
+ * @param proc (PCB *): The process owning the buffer (must be the current process).
+ * @param addr (void *): Start of the user buffer in region 1.
+ * @param len (int): Length of the buffer in bytes.
+ * @param prot (int): PROT_WRITE if the kernel is going to write into the buffer, PROT_READ otherwise.
+ * ======================== Returns ===========================
+ * @returns SUCCESS with every page pinned, or ERROR with none pinned if a page is unmapped, not
+ *          writable when it has to be, or could not be brought in.
+ * 
+*/
+int PinUserBuffer(PCB *proc, void *addr, int len, int prot);
+
+/**
+ * ======================== Description =======================
+ * @brief Drops the pins taken by a successful PinUserBuffer() on the same buffer.
+ * ======================== Parameters ========================
+ * @param proc (PCB *): The process owning the buffer.
+ * @param addr (void *): Start of the user buffer in region 1.
+ * @param len (int): Length of the buffer in bytes.
+ * ======================== Returns ===========================
+ * @returns Nothing
+ * 
+*/
+void UnpinUserBuffer(PCB *proc, void *addr, int len);
+
 
 #endif
\ No newline at end of file
@@ -5,6 +5,8 @@
 #include "hardware.h"
 #include "ykernel.h"   /* contains PCB type if you put it there */
 #include "queue.h"
+#include "waitqueue.h"
+#include "syscalls/custom.h"
 
 #define IDLE_PID         0         /* pid reserved for the kernel idle process */
 #define INVALID_PID      (-1)  /* Entries in the processes table that have this value mean that this pid is free to use */
@@ -12,6 +14,19 @@
 #define USER_MEM_START    VMEM_1_BASE
 #define USER_STACK_BASE   VMEM_1_LIMIT
 
+/* Software bits kept per region 1 page in PCB.page_flags (the hardware pte has no spare bits for us) */
+#define PAGE_COW          0x1      /* page is shared read-only after Fork and was originally writable */
+#define PAGE_LAZY         0x2      /* page is not loaded yet; filled on first touch from page_backing */
+#define PAGE_SWAPPED      0x4      /* page is on disk; the invalid pte's pfn field holds its swap slot */
+#define PAGE_SHARED       0x8      /* Shared_Pages mapping; Fork shares it read/write instead of copy-on-write */
+
+/* Where a demand-paged region 1 page gets its contents from (see LoadLazyPage) */
+typedef struct page_backing {
+    int file_offset;         /* offset of the page in the executable */
+    int file_len;            /* bytes to read from the executable; the rest of the page is zero-filled */
+    int prot;                /* protection to map the page with once it is loaded */
+} page_backing_t;
+
 /* process state */
 typedef enum {
     PROC_FREE = 0,
@@ -27,6 +42,8 @@ typedef struct pcb PCB;
 /* Process Control Block */
 typedef struct pcb {
     int pid;                 /* process id (unique) */
+    int slot;                /* index of this PCB in proc_table */
+    PCB *pid_hash_next;      /* next PCB in the same pid hash bucket (see findPCB) */
     proc_state_t state;      /* current state */
     int ppid;                /* parent pid (-1 if none) */
     int exit_status;         /* status for Wait; valid if PROC_ZOMBIE */
@@ -34,6 +51,12 @@ typedef struct pcb {
     /* The MMU registers REG_PTBR1/REG_PTLR1 are set to these during context-switch. */
     pte_t *ptbr;             /* virtual address of page table for region 1 */
     unsigned int ptlr;       /* number of entries in this page table for region 1*/
+    unsigned char page_flags[MAX_PT_LEN]; /* PAGE_* software bits for each region 1 page */
+    page_backing_t page_backing[MAX_PT_LEN]; /* backing of PAGE_LAZY pages */
+    int exec_fd;             /* open executable backing PAGE_LAZY pages (-1 if none) */
+    struct exec_image *image; /* cached executable image whose text frames we map (NULL if none) */
+    int swap_busy;           /* > 0 while blocked in the middle of our own swap I/O; pins our pages */
+    int reap_pending;        /* exited, and its kernel stack is still waiting on reap_queue to be freed */
 
     UserContext user_context; /* Full user cpu snapshow*/
 
@@ -46,36 +69,41 @@ typedef struct pcb {
     unsigned int user_heap_end_vaddr;   /* current brk (lowest not-in-use address) */
     unsigned int user_stack_base_vaddr; /* top of user stack (initial) */
 
-    /* Scheduling queue pointers */
+    /* Scheduling queue pointers (intrusive proc_list_t links, see queue.h) */
     PCB *next;
     PCB *prev;
+    struct proc_list *on_list; /* list this process is linked on through next/prev (NULL if none) */
     PCB *parent;
     queue_t *children_processes;
+    proc_list_t zombie_children; /* exited children not yet reaped by Wait/WaitPid, linked through next/prev */
 
 
     /* bookkeeping flags */
-    int waiting_for_child_pid;  /* if parent is blocked waiting for child (Wait) */
+    wait_queue_t child_exit;    /* where this process sleeps in Wait/WaitPid until one of its children exits */
     int last_run_tick;          /* last tick when this process ran (scheduler info) */
-    int delay_ticks;   /* How muany more ticks should this process be delayed for */
+    int priority;               /* MLFQ level, 0 is the highest (see sched.h) */
+    int quantum;                /* base time slice in ticks; the slice at level l is quantum << l */
+    int ticks_left;             /* ticks left in the current slice (refilled by the scheduler) */
+    int tickets;                /* CPU share under the stride policy (see SetShare) */
+    unsigned int stride;        /* SCHED_STRIDE1 / tickets: pass advance per tick run */
+    unsigned int pass;          /* stride virtual time; the ready process with the lowest pass runs next */
+    unsigned int cpu_ticks;     /* clock ticks this process has been charged with since it was created */
+    unsigned int switches_out;  /* times KCSwitch has switched away from this process */
+    syscall_stat_t syscall_stats[SYSCALL_STAT_SLOTS]; /* this process's syscalls, see KERNEL_OP_STATS */
+    unsigned int wake_tick;     /* timer_ticks value at which a Delay ends (see timer.h) */
 
     /* bookkeeping for terminal operations */
-    void *tty_read_buf;  // Pointer to buffer in user space for TTY read operations.
+    void *tty_read_buf;  // Pointer to buffer in user space for TTY read operations (resident and pinned while blocked)
     int tty_read_len;    // Length of TTY read buffer
     void *tty_write_buf; // Pointer to buffer in user space for TTY write operations
     int tty_write_len;   // Length of TTY write buffer
-
-    void *tty_kernel_read_buf; // Pointer to read buffer in kernel space.
-    int kernel_read_size;
 } PCB;
 
 extern PCB *idle_proc; // Pointer to the idle process PCB
 extern PCB *init_proc;
 extern PCB *current_process; // Pointer to the current running process PCB
 
-extern queue_t *ready_queue; // A FIFO queue of processes ready to be executed by the cpu
-extern queue_t *blocked_queue; // A queue of processes blocked (either waiting on a lock, cvar or waiting for an I/O to finish)
-extern queue_t *zombie_queue; // A queue of processes that have terminated but whose parent has not yet called Wait()
-extern queue_t *waiting_parents; // A queue of processes blocked waiting for a child to exit;
+extern queue_t *reap_queue; // Exited processes whose kernel stacks still have to be freed (see ReapExitedProcesses)
 
 extern PCB **proc_table; // List of processes. Not all of them are actual processes but are pointers to processes that could be initialized by LoadProgram
 
@@ -100,25 +128,52 @@ PCB *allocNewPCB(void); // Allocates memory and initializes one PCB (used only d
  * @brief Cleans up and frees a PCB and its associated resources.
  * ======================== Behavior ==========================
  * - Orphans any child processes (sets their parent to NULL).
- * - Frees region 1 page table and the children queue.
- * - Removes PCB from any linked list if applicable.
+ * - Frees whatever is left of region 1 and the kernel stack frames, then the page table and children queue.
+ * - Takes the PCB off reap_queue if it is still there and releases its proc_table slot and pid.
  * ======================== Notes =============================
- * - Does NOT yet free user memory pages (handled separately in VM cleanup).
- * - Should only be called when process is fully terminated.
+ * - Should only be called when process is fully terminated, and never on the kernel stack being freed.
  */
 void deletePCB(PCB *process);
 
+/**
+ * ======================== Description =======================
+ * @brief Frees the frames of a process's kernel stack and its kstack page table entries.
+ * ======================== Notes =============================
+ * - Must not be called while running on that stack; Exit defers it to ReapExitedProcesses().
+ */
+void ReleaseKernelStack(PCB *process);
+
+/**
+ * ======================== Description =======================
+ * @brief Finishes off exited processes on reap_queue: frees their kernel stacks and, for orphans
+ *        nobody will Wait for, the whole PCB. Runs from the clock trap, on some other process's stack.
+ */
+void ReapExitedProcesses(void);
+
 /**
  * ======================== Description =======================
  * @brief Returns a free PCB slot from the global process table.
  * ======================== Behavior ==========================
- * - Iterates over the process table to find a PCB marked `PROC_FREE`.
+ * - Pops a free slot off the free-slot stack in O(1), allocates a PCB for it and
+ *   registers its new pid in the pid hash.
  * ======================== Returns ===========================
  * @returns Pointer to a free PCB if found, NULL otherwise.
  */
 PCB *getFreePCB(void); // Retrieves an unused PCB from proc_table for process creation
 
-void CloneRegion1(PCB *pcb_from, PCB *pcb_to);
+/**
+ * ======================== Description =======================
+ * @brief Looks a live (or zombie) process up by pid through the pid hash, in O(1) expected time.
+ * ======================== Returns ===========================
+ * @returns The PCB, or NULL if no process has that pid.
+ */
+PCB *findPCB(int pid);
+
+/**
+ * ======================== Description =======================
+ * @brief Resets the free proc_table slot stack and the pid hash. Called by InitializeProcTable.
+ */
+void InitializePidIndex(void);
 
 /**
  * ======================== Description =======================
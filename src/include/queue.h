@@ -100,4 +100,68 @@ int is_empty(queue_t *queue);
 void print_queue(queue_t *queue);
 void queueIterate(queue_t *queue, void *arg, void (*itemfunc)(void *arg, PCB *process));
 
+/*
+ * Intrusive process lists. The PCB's own next/prev fields are the links, so
+ * enqueue/dequeue never allocate and removal is O(1). PCB.on_list says which list
+ * a process is on; a process can be on at most one of these at a time, which fits
+ * scheduling state (ready, blocked, sleeping). Relationships a process has in
+ * parallel (children, zombies, terminal waiters) stay on queue_t.
+ */
+typedef struct proc_list {
+    PCB *head;
+    PCB *tail;
+    int count;
+} proc_list_t;
+
+/**
+ * ======================== Description =======================
+ * @brief Initializes an empty intrusive process list.
+ * ======================== Parameters ========================
+ * @param list (proc_list_t*): The list to initialize.
+ * ======================== Returns ==========================
+ * @returns void
+ */
+void procListInit(proc_list_t *list);
+
+/**
+ * ======================== Description =======================
+ * @brief Links a process at the tail of a list in O(1).
+ * ======================== Parameters ========================
+ * @param list (proc_list_t*): The list to append to.
+ * @param process (PCB*): The process, which must not be on any list yet.
+ * ======================== Returns ==========================
+ * @returns void. Halts the system if the process is already on a list.
+ */
+void procListEnqueue(proc_list_t *list, PCB *process);
+
+/**
+ * ======================== Description =======================
+ * @brief Unlinks and returns the process at the head of a list in O(1).
+ * ======================== Parameters ========================
+ * @param list (proc_list_t*): The list to take from.
+ * ======================== Returns ==========================
+ * @returns The head process, or NULL if the list is empty.
+ */
+PCB *procListDequeue(proc_list_t *list);
+
+/**
+ * ======================== Description =======================
+ * @brief Unlinks a process from whatever list it is on (PCB.on_list) in O(1).
+ * ======================== Parameters ========================
+ * @param process (PCB*): The process to unlink. Nothing happens if it isn't on a list.
+ * ======================== Returns ==========================
+ * @returns void
+ */
+void procListRemove(PCB *process);
+
+/**
+ * ======================== Description =======================
+ * @brief Checks whether a list is empty.
+ * ======================== Parameters ========================
+ * @param list (proc_list_t*): The list to check.
+ * ======================== Returns ==========================
+ * @returns 1 if the list is empty, 0 otherwise.
+ */
+int procListIsEmpty(proc_list_t *list);
+
 #endif
\ No newline at end of file
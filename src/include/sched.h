@@ -0,0 +1,191 @@
+#ifndef SCHED_H
+#define SCHED_H
+
+#include "proc.h"
+#include "queue.h"
+
+/*
+ * Scheduler front end. The rest of the kernel only goes through the Sched* functions below;
+ * the actual decisions are made by the policy in sched_ops, picked at boot with the
+ * "sched=" option:
+ *
+ *   rr    Round robin: one FIFO, every process gets its base quantum.
+ *   mlfq  Multi-level feedback queue (default). Level 0 is the highest priority. A process
+ *         that runs through its whole slice drops one level, a process that blocks on I/O
+ *         (terminal or disk) moves up one level, and every SCHED_BOOST_PERIOD ticks everybody
+ *         goes back to level 0 so CPU-bound processes can't starve.
+ *   stride Proportional share. Each process holds tickets (SetShare) and its pass grows by
+ *         SCHED_STRIDE1 / tickets for every tick it runs; the ready process with the lowest
+ *         pass runs next, so CPU time is split in proportion to tickets. A process waking
+ *         from a sleep is moved up to the current pass so it can't bank CPU time while asleep.
+ *
+ * Each process has a base quantum (default_quantum unless changed with SetQuantum); its
+ * slice at level l is quantum << l ticks. Policies without levels leave priority at 0.
+ */
+#define SCHED_LEVELS        3
+#define SCHED_BOOST_PERIOD  50   /* ticks between priority resets */
+
+#define SCHED_MAX_QUANTUM   64   /* largest base quantum SetQuantum accepts */
+
+#define SCHED_STRIDE1           (1 << 20) /* pass advance per tick of a process holding one ticket */
+#define SCHED_DEFAULT_TICKETS   100
+#define SCHED_MAX_TICKETS       1000
+
+/* A scheduling policy. Hooks that a policy doesn't need may be NULL, except those marked required */
+typedef struct sched_ops {
+    char *name;                      /* name used by the "sched=" boot option */
+    void (*init)(void);              /* required: set up the run queues */
+    void (*enqueue)(PCB *proc);      /* required: proc is ready, add it to the run queue */
+    void (*dequeue)(PCB *proc);      /* required: take a ready proc back off the run queue */
+    PCB *(*pick_next)(void);         /* required: remove and return the next process, NULL if none */
+    int (*has_ready)(void);          /* required: 1 if pick_next would return a process */
+    int (*on_tick)(PCB *curr);       /* required: charge a clock tick to curr (may be idle_proc); 1 to preempt it */
+    void (*on_block)(PCB *proc);     /* proc is about to sleep on terminal or disk I/O */
+    void (*on_wake)(PCB *proc);      /* proc was woken from a sleep, just before it is enqueued */
+    int (*can_handoff)(PCB *curr, PCB *to); /* whether curr may switch straight to the ready process to; NULL = always */
+} sched_ops_t;
+
+extern sched_ops_t sched_rr_ops;
+extern sched_ops_t sched_mlfq_ops;
+extern sched_ops_t sched_stride_ops;
+
+extern sched_ops_t *sched_ops;  /* the policy in use, "sched=" boot option */
+extern int default_quantum;     /* base quantum of new processes, "quantum=N" boot option */
+
+/**
+ * ======================== Description =======================
+ * @brief Selects the scheduling policy by name. Only valid before InitializeScheduler.
+ * ======================== Parameters ========================
+ * @param name (char *): "rr", "mlfq" or "stride".
+ * ======================== Returns ===========================
+ * @returns SUCCESS, or ERROR (keeping the current policy) if no policy has that name.
+ */
+int SchedSelectPolicy(char *name);
+
+/**
+ * ======================== Description =======================
+ * @brief Initializes the selected policy's run queues. Called once from KernelStart.
+ * ======================== Returns ===========================
+ * @returns void
+ */
+void InitializeScheduler(void);
+
+/**
+ * ======================== Description =======================
+ * @brief Starts a new slice for proc at its current level. For use by policies.
+ * ======================== Parameters ========================
+ * @param proc (PCB *): The process.
+ * ======================== Returns ===========================
+ * @returns void
+ */
+void SchedRefillSlice(PCB *proc);
+
+/**
+ * ======================== Description =======================
+ * @brief Marks a process PROC_READY and hands it to the policy's run queue.
+ * ======================== Parameters ========================
+ * @param proc (PCB *): The process that can run again.
+ * ======================== Returns ===========================
+ * @returns void
+ */
+void SchedReady(PCB *proc);
+
+/**
+ * ======================== Description =======================
+ * @brief Like SchedReady, for a process coming back from a sleep (wait queues, timer wheel).
+ *        Gives the policy a chance to adjust it first.
+ * ======================== Parameters ========================
+ * @param proc (PCB *): The woken process.
+ * ======================== Returns ===========================
+ * @returns void
+ */
+void SchedWake(PCB *proc);
+
+/**
+ * ======================== Description =======================
+ * @brief Dequeues the process the policy wants to run next.
+ * ======================== Returns ===========================
+ * @returns The next process, or idle_proc if nothing is ready.
+ */
+PCB *SchedPickNext(void);
+
+/**
+ * ======================== Description =======================
+ * @brief Returns whether any process is waiting on a ready queue.
+ * ======================== Returns ===========================
+ * @returns 1 if some process is ready, 0 otherwise.
+ */
+int SchedHasReady(void);
+
+/**
+ * ======================== Description =======================
+ * @brief Called when a process gives up the CPU to wait for I/O. Lets the policy reward it
+ *        and gives it a fresh slice.
+ * ======================== Parameters ========================
+ * @param proc (PCB *): The process about to block.
+ * ======================== Returns ===========================
+ * @returns void
+ */
+void SchedBlockedOnIO(PCB *proc);
+
+/**
+ * ======================== Description =======================
+ * @brief Asks the policy whether curr may switch straight to a process that was just made ready,
+ *        bypassing pick_next (see WaitQueueHandoff).
+ * ======================== Parameters ========================
+ * @param curr (PCB *): The running process.
+ * @param to (PCB *): The ready process.
+ * ======================== Returns ===========================
+ * @returns 1 if the handoff is allowed, 0 if to has to wait for its turn on the ready queue.
+ */
+int SchedCanHandoff(PCB *curr, PCB *to);
+
+/**
+ * ======================== Description =======================
+ * @brief Prepares a direct switch from curr to a process that was just made ready. Takes to
+ *        off its ready queue; if curr is giving up the CPU for good (blocked or exited) to
+ *        inherits what is left of curr's slice, otherwise curr is requeued with its slice intact.
+ * ======================== Parameters ========================
+ * @param curr (PCB *): The running process.
+ * @param to (PCB *): The ready process to run next.
+ * ======================== Returns ===========================
+ * @returns void
+ */
+void SchedHandoff(PCB *curr, PCB *to);
+
+/**
+ * ======================== Description =======================
+ * @brief Charges a clock tick to the running process (counted in its cpu_ticks) and lets the
+ *        policy decide whether to preempt it.
+ * ======================== Parameters ========================
+ * @param curr (PCB *): The process that was running when the clock ticked.
+ * ======================== Returns ===========================
+ * @returns 1 if the policy wants curr preempted, 0 otherwise.
+ */
+int SchedTick(PCB *curr);
+
+/**
+ * ======================== Description =======================
+ * @brief Changes the base quantum of a process. Its current slice is left alone; the new
+ *        length applies from its next slice on.
+ * ======================== Parameters ========================
+ * @param proc (PCB *): The process.
+ * @param ticks (int): New base quantum, 1..SCHED_MAX_QUANTUM, or 0 for default_quantum.
+ * ======================== Returns ===========================
+ * @returns The previous base quantum, or ERROR if ticks is out of range.
+ */
+int SchedSetQuantum(PCB *proc, int ticks);
+
+/**
+ * ======================== Description =======================
+ * @brief Changes the stride tickets of a process. Its pass is kept, so the new share applies
+ *        from its next tick on.
+ * ======================== Parameters ========================
+ * @param proc (PCB *): The process.
+ * @param tickets (int): New ticket count, 1..SCHED_MAX_TICKETS, or 0 for SCHED_DEFAULT_TICKETS.
+ * ======================== Returns ===========================
+ * @returns The previous ticket count, or ERROR if tickets is out of range.
+ */
+int SchedSetShare(PCB *proc, int tickets);
+
+#endif
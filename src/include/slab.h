@@ -0,0 +1,55 @@
+#ifndef SLAB_H
+#define SLAB_H
+
+#include "hardware.h"
+#include "ykernel.h"
+
+/*
+ * Object caches for the kernel's fixed-size, high-churn objects (PCBs, page tables,
+ * queues and queue nodes). Each cache carves whole pages into equal objects and keeps
+ * freed objects on an intrusive free list, so allocation and free are O(1) and never
+ * walk the general-purpose kernel heap.
+ *
+ * Slab pages are mapped into region 0 in their own area that grows down from the
+ * scratch window, while the malloc heap grows up to meet it (SetKernelBrk stops at
+ * slab_low_page). Slab pages are never given back, so fragmentation is bounded by the
+ * peak number of live objects of each type.
+ */
+typedef struct slab_cache {
+    char *name;              /* for tracing */
+    int obj_size;            /* bytes per object, rounded up to a word */
+    void *free_list;         /* free objects; the first word of each points to the next */
+    int npages;              /* slab pages carved for this cache */
+    int nfree;               /* objects currently on the free list */
+} slab_cache_t;
+
+// Static initializer for a cache. A size of 0 or more than a page doesn't compile (negative array size)
+#define SLAB_CACHE_INIT(cache_name, size) \
+    { (cache_name), (int)((((size) + sizeof(void *) - 1) & ~(sizeof(void *) - 1)) + \
+                          0 * sizeof(char[((size) > 0 && (size) <= PAGESIZE) ? 1 : -1])), NULL, 0, 0 }
+
+extern int slab_low_page; /* lowest region 0 vpn used by slab pages (the heap must stay below it) */
+
+/**
+ * ======================== Description =======================
+ * @brief Allocates one object from a cache, carving a fresh page when its free list is empty.
+ * ======================== Parameters ========================
+ * @param cache (slab_cache_t *): The cache to allocate from.
+ * ======================== Returns ===========================
+ * @returns Pointer to an uninitialized object, or NULL if no page could be mapped or the cache's
+ *          obj_size doesn't fit a slab page.
+ */
+void *slabAlloc(slab_cache_t *cache);
+
+/**
+ * ======================== Description =======================
+ * @brief Returns an object to the free list of the cache it was allocated from.
+ * ======================== Parameters ========================
+ * @param cache (slab_cache_t *): The cache the object came from.
+ * @param obj (void *): The object, may be NULL.
+ * ======================== Returns ===========================
+ * @returns void
+ */
+void slabFree(slab_cache_t *cache, void *obj);
+
+#endif
@@ -0,0 +1,87 @@
+#ifndef SWAP_H
+#define SWAP_H
+
+#include "hardware.h"
+#include "ykernel.h"
+#include "proc.h"
+
+/*
+ * Swap area on the simulated disk. Every swap slot holds one page and spans
+ * SECTORS_PER_PAGE consecutive sectors starting at SWAP_FIRST_SECTOR.
+ * A swapped out region 1 page keeps an invalid pte whose pfn field holds the
+ * swap slot, and is tagged PAGE_SWAPPED in the owner's page_flags.
+ */
+#define SECTORS_PER_PAGE   (PAGESIZE / SECTORSIZE)
+#define SWAP_FIRST_SECTOR  0
+#define SWAP_NSLOTS        ((NUMSECTORS - SWAP_FIRST_SECTOR) / SECTORS_PER_PAGE)
+
+extern int swap_enabled; /* "swap=1" kernel option */
+
+/**
+ * ======================== Description =======================
+ * @brief Allocates the swap slot table and the kernel bounce buffer used for disk transfers.
+ *        Disables swapping if memory runs out.
+ * ======================== Parameters ========================
+ * @param None
+ * ======================== Returns ===========================
+ * @returns void
+ */
+void InitializeSwap(void);
+
+/**
+ * ======================== Description =======================
+ * @brief Evicts one user page to disk, choosing the victim with a second-chance clock over all
+ *        processes' region 1 page tables. Only private (refcount 1) user frames of processes other than the
+ *        current one, and not pinned in the middle of their own swap I/O, are candidates.
+ *        Blocks the current process while the page is written out.
+ * ======================== Parameters ========================
+ * @param None
+ * ======================== Returns ===========================
+ * @returns SUCCESS if a frame was freed.
+ * @returns ERROR if swapping is off, can't block here (idle/boot), or there is no victim or free slot.
+ */
+int SwapEvictOne(void);
+
+/**
+ * ======================== Description =======================
+ * @brief Reads a PAGE_SWAPPED page of the current process back from disk into a new frame and maps it
+ *        again with its old protection. Blocks while the page is read.
+ * ======================== Parameters ========================
+ * @param proc (PCB *): The faulting process (must be the current process).
+ * @param vpn (int): The region 1 page to bring back.
+ * ======================== Returns ===========================
+ * @returns SUCCESS if the page is mapped again, ERROR otherwise.
+ */
+int SwapIn(PCB *proc, int vpn);
+
+/**
+ * ======================== Description =======================
+ * @brief Takes an extra reference on a swap slot (a forked child sharing a swapped out page).
+ * ======================== Parameters ========================
+ * @param slot (int): The swap slot.
+ * ======================== Returns ===========================
+ * @returns void
+ */
+void SwapRefSlot(int slot);
+
+/**
+ * ======================== Description =======================
+ * @brief Drops one reference to a swap slot; the last reference makes it free again.
+ * ======================== Parameters ========================
+ * @param slot (int): The swap slot.
+ * ======================== Returns ===========================
+ * @returns void
+ */
+void SwapFreeSlot(int slot);
+
+/**
+ * ======================== Description =======================
+ * @brief Called from the TRAP_DISK handler: wakes the process waiting on the finished transfer.
+ * ======================== Parameters ========================
+ * @param None
+ * ======================== Returns ===========================
+ * @returns void
+ */
+void SwapDiskInterrupt(void);
+
+#endif
@@ -0,0 +1,92 @@
+#ifndef CUSTOM_H
+#define CUSTOM_H
+
+/*
+ * Kernel extensions reached through the YALNIX_CUSTOM_* syscall numbers. This header
+ * is shared with user programs (they get src/include on their include path), so it only
+ * holds plain constants and structs and, when yuser.h was included first, user-side
+ * wrappers around yuser's Custom0/1/2.
+ *
+ *   YALNIX_CUSTOM_0: WaitPid(pid, status_ptr, flags), flags a mask of WAIT_*
+ *   YALNIX_CUSTOM_1: scheduling controls, Custom1(op, a, b, c) with op one of SCHED_OP_*
+ *   YALNIX_CUSTOM_2: everything else, Custom2(op, a, b, c) with op one of KERNEL_OP_*
+ */
+
+/* YALNIX_CUSTOM_0 flags */
+#define WAIT_NOHANG           0x1 /* return 0 instead of blocking when no matching child has exited */
+
+/* YALNIX_CUSTOM_1 operations */
+#define SCHED_OP_SET_QUANTUM  1   /* (pid, ticks): set pid's base quantum, 0 = boot default. Returns the old one */
+#define SCHED_OP_SET_SHARE    2   /* (pid, tickets): set pid's stride tickets, 0 = default. Returns the old count */
+#define SCHED_OP_GET_TICKS    3   /* (pid): clock ticks pid has run so far */
+
+/* YALNIX_CUSTOM_2 operations */
+#define KERNEL_OP_BATCH       1   /* (descs, n): run a syscall batch, see syscall_desc_t. Returns entries run */
+#define KERNEL_OP_STATS       2   /* (pid, stats, n): copy up to n syscall_stat_t of pid (-1 = whole system). Returns SYSCALL_STAT_SLOTS */
+#define KERNEL_OP_MEM_STATS   3   /* (stats): copy the system's mem_stat_t. Returns SUCCESS */
+
+/*
+ * One entry of a KERNEL_OP_BATCH batch. The kernel runs the entries in order and stores each
+ * return value in result. A syscall that may block (Delay, Wait, WaitPid, TtyRead, TtyWrite)
+ * ends the batch once it has completed. Fork, Exec, Exit, nested batches and unknown numbers
+ * get ERROR and end it too. The batch returns how many entries ran, so the caller can
+ * resubmit the rest.
+ */
+#define SYSCALL_BATCH_MAX     64
+
+typedef struct syscall_desc {
+    int code;             /* YALNIX_* syscall number */
+    int args[4];          /* arguments, as the plain syscall takes them */
+    int result;           /* written by the kernel */
+} syscall_desc_t;
+
+/*
+ * Per-syscall counters, one syscall_stat_t per SYSCALL_STAT_* slot, kept for every process and
+ * for the whole system. Ticks are clock ticks between trap entry and return, so a call that
+ * blocks is charged for the time it slept; most immediate calls take 0.
+ */
+enum {
+    SYSCALL_STAT_FORK,
+    SYSCALL_STAT_EXEC,
+    SYSCALL_STAT_EXIT,
+    SYSCALL_STAT_WAIT,
+    SYSCALL_STAT_GETPID,
+    SYSCALL_STAT_BRK,
+    SYSCALL_STAT_DELAY,
+    SYSCALL_STAT_TTY_READ,
+    SYSCALL_STAT_TTY_WRITE,
+    SYSCALL_STAT_SHARED_PAGES,
+    SYSCALL_STAT_WAITPID,         /* YALNIX_CUSTOM_0 */
+    SYSCALL_STAT_SCHED_CONTROL,   /* YALNIX_CUSTOM_1 */
+    SYSCALL_STAT_KERNEL_OP,       /* YALNIX_CUSTOM_2 */
+    SYSCALL_STAT_SLOTS
+};
+
+typedef struct syscall_stat {
+    unsigned int calls;
+    unsigned int errors;          /* calls that returned ERROR */
+    unsigned int blocked;         /* calls during which the caller was switched out */
+    unsigned int total_ticks;
+    unsigned int max_ticks;
+} syscall_stat_t;
+
+/* Physical memory counters for KERNEL_OP_MEM_STATS */
+typedef struct mem_stat {
+    unsigned int free_frames;
+    unsigned int zeroed_frames;     /* free frames the idle process has already zeroed */
+    unsigned int zero_pool_hits;    /* zero-filled allocations served from the pre-zeroed pool */
+    unsigned int zero_pool_misses;  /* zero-filled allocations that had to clear a frame inline */
+} mem_stat_t;
+
+#ifdef _YUSER_H_
+/* User-side wrappers; include after yuser.h. The kernel has its own functions by these names */
+#define WaitPid(pid, status_ptr, flags)  Custom0((pid), (int)(status_ptr), (flags), 0)
+#define SetQuantum(pid, ticks)  Custom1(SCHED_OP_SET_QUANTUM, (pid), (ticks), 0)
+#define SetShare(pid, tickets)  Custom1(SCHED_OP_SET_SHARE, (pid), (tickets), 0)
+#define GetTicks(pid)           Custom1(SCHED_OP_GET_TICKS, (pid), 0, 0)
+#define SyscallBatch(descs, n)  Custom2(KERNEL_OP_BATCH, (int)(descs), (n), 0)
+#define SyscallStats(pid, stats, n)  Custom2(KERNEL_OP_STATS, (pid), (int)(stats), (n))
+#define MemStats(stats)         Custom2(KERNEL_OP_MEM_STATS, (int)(stats), 0, 0)
+#endif
+
+#endif
@@ -1,15 +1,77 @@
 #ifndef PROCESS_H
 #define PROCESS_H
 
+#include "proc.h"
+
 #define SYSCALLS_TRACE_LEVEL    0
 
 int Fork (void);
 int Exec (char * file, char ** argvec);
 void Exit (int status);
 int Wait (int * status_ptr);
+
+/**
+ * ======================== Description =======================
+ * @brief Reaps an exited child. Reached through YALNIX_CUSTOM_0 (see syscalls/custom.h); Wait is WaitPid(-1, status_ptr, 0).
+ * ======================== Parameters ========================
+ * @param pid (int): Child to reap, or -1 for any child.
+ * @param status_ptr (int*): Where to store the child's exit status (may be NULL).
+ * @param flags (int): WAIT_NOHANG to return 0 instead of blocking when no matching child has exited.
+ * ======================== Returns ===========================
+ * @returns The reaped child's pid, 0 under WAIT_NOHANG, or ERROR if the caller has no such child or
+ *          status_ptr isn't writable (the child is not reaped then).
+ */
+int WaitPid(int pid, int *status_ptr, int flags);
 int GetPid (void);
 int Delay(int clock_ticks);
 int Brk(void *addr);
 
+/**
+ * ======================== Description =======================
+ * @brief Sets the base time slice of the caller (pid 0 or its own pid) or of one of its children.
+ *        Reached through YALNIX_CUSTOM_1 with SCHED_OP_SET_QUANTUM (see syscalls/custom.h).
+ * ======================== Parameters ========================
+ * @param pid (int): Target process.
+ * @param ticks (int): New base quantum in clock ticks, 0 for the boot default.
+ * ======================== Returns ===========================
+ * @returns The previous quantum, or ERROR for a bad pid or tick count.
+ */
+int SetQuantum(int pid, int ticks);
+
+/**
+ * ======================== Description =======================
+ * @brief Resolves the pid passed to a control or statistics call: the caller itself (pid 0 or
+ *        its own pid) or one of its children.
+ * ======================== Parameters ========================
+ * @param pid (int): The pid passed by the caller.
+ * @param allow_zombie (int): Whether an exited, not yet reaped child counts (for read-only calls).
+ * ======================== Returns ===========================
+ * @returns The target PCB, or NULL if the caller may not act on pid.
+ */
+PCB *ControlTarget(int pid, int allow_zombie);
+
+/**
+ * ======================== Description =======================
+ * @brief Sets the CPU share (stride tickets) of the caller or of one of its children.
+ *        Reached through YALNIX_CUSTOM_1 with SCHED_OP_SET_SHARE; only the stride policy uses it.
+ * ======================== Parameters ========================
+ * @param pid (int): Target process, 0 for the caller.
+ * @param tickets (int): New ticket count, 1..SCHED_MAX_TICKETS, or 0 for SCHED_DEFAULT_TICKETS.
+ * ======================== Returns ===========================
+ * @returns The previous ticket count, or ERROR for a bad pid or ticket count.
+ */
+int SetShare(int pid, int tickets);
+
+/**
+ * ======================== Description =======================
+ * @brief Returns how many clock ticks the caller or one of its (possibly exited) children has run.
+ *        Reached through YALNIX_CUSTOM_1 with SCHED_OP_GET_TICKS.
+ * ======================== Parameters ========================
+ * @param pid (int): Target process, 0 for the caller.
+ * ======================== Returns ===========================
+ * @returns The cumulative tick count, or ERROR for a bad pid.
+ */
+int GetTicks(int pid);
+
 
 #endif
\ No newline at end of file
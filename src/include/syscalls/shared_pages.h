@@ -0,0 +1,22 @@
+#ifndef SHARED_PAGES_H
+#define SHARED_PAGES_H
+
+#include "proc.h"
+
+// Pages kept free right below the user stack so it can still grow after Shared_Pages
+#define SHARED_STACK_RESERVE 4
+
+/**
+ * ======================== Description =======================
+ * @brief Maps n freshly zeroed frames read/write into the caller's region 1, in the gap between the heap
+ *        and the stack. The pages are marked PAGE_SHARED, so Fork children map the very same frames
+ *        (no copy-on-write) and both sides see each other's writes.
+ * ======================== Parameters ========================
+ * @param n (int): Number of pages to map.
+ * ======================== Returns ===========================
+ * @returns The user address of the lowest mapped page, or 0 on failure.
+ *
+*/
+int Shared_Pages(int n);
+
+#endif
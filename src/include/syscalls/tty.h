@@ -3,13 +3,27 @@
 
 #include "queue.h"
 #include "proc.h"
+
+/*
+ * Terminal input is kept in a per-terminal ring of tty_input_size bytes (a power of two,
+ * "ttybuf=N" boot option). read_head and read_tail run freely and are masked on use, so
+ * tail - head is the number of unread bytes and consuming input never moves any data.
+ */
+#define TTY_INPUT_DEFAULT_SIZE  (4 * TERMINAL_MAX_LINE)
+#define TTY_INPUT_MAX_SIZE      (64 * TERMINAL_MAX_LINE)
+
+extern int tty_input_size;
+
 typedef struct terminal {
-    queue_t *blocked_writers; // Queue of processes waiting to write to the terminal
-    queue_t *blocked_readers; // Queue of processes waiting to read from the terminal
+    wait_queue_t blocked_writers; // Processes waiting for their turn to write to the terminal
+    wait_queue_t blocked_readers; // Processes waiting for input on the terminal
+    wait_queue_t write_done;      // The current writer, waiting for its transmission to finish
     int tty_id;                   // ID identifier for the terminal
-    int read_buffer_len;      // Number of bytes available to be read from the read buffer
+    unsigned int read_head;   // Ring index of the next byte to hand to a reader
+    unsigned int read_tail;   // Ring index where the next received byte goes
+    unsigned int read_dropped; // Received bytes thrown away because the ring was full
     int write_buffer_len;     // Total length of write buffer
-    char *read_buffer;        // Buffer holding read data
+    char *read_buffer;        // Input ring of tty_input_size bytes
     char *write_buffer;       // Buffer holding data to be written
     int write_buffer_position; // Current position in write buffer
     PCB *current_writer;       // Current process writing  to the buffer
@@ -19,8 +33,78 @@ typedef struct terminal {
 extern terminal_t terminals[NUM_TERMINALS];
 
 int BeginTtyTransmit(int tty_id, PCB *writer, void *buf, int len);
+
+/**
+ * ======================== Description =======================
+ * @brief Rounds a requested input ring size up to a power of two within
+ *        [TERMINAL_MAX_LINE, TTY_INPUT_MAX_SIZE]. Used for the "ttybuf=N" boot option.
+ * ======================== Parameters ========================
+ * @param size (int): Requested size in bytes.
+ * ======================== Returns ===========================
+ * @returns The ring size to use.
+*/
+int TtyInputRoundSize(int size);
+
+/**
+ * ======================== Description =======================
+ * @brief Returns how many received bytes are waiting in a terminal's input ring.
+ * ======================== Parameters ========================
+ * @param terminal (terminal_t *): The terminal.
+ * ======================== Returns ===========================
+ * @returns Number of unread bytes.
+*/
+int TtyInputAvailable(terminal_t *terminal);
+
+/**
+ * ======================== Description =======================
+ * @brief Appends received bytes to a terminal's input ring. Bytes that don't fit are dropped
+ *        and counted in read_dropped.
+ * ======================== Parameters ========================
+ * @param terminal (terminal_t *): The terminal.
+ * @param data (char *): The received bytes.
+ * @param len (int): How many there are.
+ * ======================== Returns ===========================
+ * @returns Number of bytes stored.
+*/
+int TtyInputAppend(terminal_t *terminal, char *data, int len);
+
+/**
+ * ======================== Description =======================
+ * @brief Moves up to len unread bytes out of a terminal's input ring, in O(bytes moved).
+ * ======================== Parameters ========================
+ * @param terminal (terminal_t *): The terminal.
+ * @param dst (char *): Where to copy them.
+ * @param len (int): Most bytes to take.
+ * ======================== Returns ===========================
+ * @returns Number of bytes copied.
+*/
+int TtyInputConsume(terminal_t *terminal, char *dst, int len);
+
+/**
+ * ======================== Description =======================
+ * @brief Moves up to len unread bytes out of a terminal's input ring straight into a sleeping
+ *        reader's user buffer (see CopyToProcess). Used by the receive trap at wake time; a reader
+ *        whose buffer isn't resident gets nothing and copies the data itself once it runs.
+ * ======================== Parameters ========================
+ * @param terminal (terminal_t *): The terminal.
+ * @param reader (PCB *): The blocked reader.
+ * @param len (int): Most bytes to take.
+ * ======================== Returns ===========================
+ * @returns Number of bytes delivered, or 0 (consuming nothing) if the buffer isn't resident.
+*/
+int TtyInputDeliver(terminal_t *terminal, PCB *reader, int len);
 int TtyRead(int tty_id, void *buf, int len);
 int TtyWrite(int tty_id, void *buf, int len);
 
+/**
+ * ======================== Description =======================
+ * @brief Drops a dying process's terminal state: any terminal still pointing at it as the current writer.
+ * ======================== Parameters ========================
+ * @param proc (PCB *): The process being torn down.
+ * ======================== Returns ===========================
+ * @returns void
+*/
+void TtyReleaseProcess(PCB *proc);
+
 
 #endif
\ No newline at end of file
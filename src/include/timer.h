@@ -0,0 +1,46 @@
+#ifndef TIMER_H
+#define TIMER_H
+
+#include "proc.h"
+#include "waitqueue.h"
+
+/*
+ * Hashed timer wheel for Delay. A sleeper whose wake-up tick is w sits in slot
+ * (w % TIMER_WHEEL_SLOTS), so each clock tick only looks at the one slot for the
+ * current tick instead of every blocked process. Sleepers more than a full turn
+ * away stay in their slot until their own tick comes around.
+ */
+#define TIMER_WHEEL_SLOTS 64
+
+extern unsigned int timer_ticks; /* clock ticks seen by the kernel since boot */
+
+/**
+ * ======================== Description =======================
+ * @brief Initializes the wheel's slot lists. Called once from KernelStart.
+ * ======================== Returns ===========================
+ * @returns void
+ */
+void InitializeTimerWheel(void);
+
+/**
+ * ======================== Description =======================
+ * @brief Puts the current process to sleep on the wheel until ticks more clock ticks have passed.
+ *        Returns once TimerTick() has woken it up.
+ * ======================== Parameters ========================
+ * @param proc (PCB *): The current process.
+ * @param ticks (int): Number of clock ticks to sleep, > 0, or -1 to sleep forever.
+ * ======================== Returns ===========================
+ * @returns void
+ */
+void TimerSleep(PCB *proc, int ticks);
+
+/**
+ * ======================== Description =======================
+ * @brief Advances the wheel by one tick and makes every process whose deadline has passed ready.
+ *        Called from the clock trap.
+ * ======================== Returns ===========================
+ * @returns void
+ */
+void TimerTick(void);
+
+#endif
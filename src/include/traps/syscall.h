@@ -0,0 +1,32 @@
+#ifndef SYSCALL_H
+#define SYSCALL_H
+
+#include <hardware.h> // UserContext
+#include <yalnix.h>   // YALNIX_MASK
+#include "syscalls/custom.h"
+
+/*
+ * Syscall dispatch. KernelTrapHandler saves the caller's UserContext into its PCB once,
+ * looks the handler up by (code & YALNIX_MASK) and copies the (possibly different, after a
+ * context switch) current process's context back out once. Handlers decode their arguments
+ * from the saved context and return the value that goes back in regs[0].
+ */
+#define SYSCALL_TABLE_SIZE (YALNIX_MASK + 1)
+
+typedef int (*syscall_handler_t)(UserContext *uctx);
+
+/* syscall_entry_t.flags, for batches (see KERNEL_OP_BATCH in syscalls/custom.h) */
+#define SYSCALL_MAY_BLOCK   0x1   /* a batch stops after this call */
+#define SYSCALL_NO_BATCH    0x2   /* only allowed as a plain trap */
+
+typedef struct syscall_entry {
+    char *name;                  /* for tracing */
+    syscall_handler_t handler;   /* NULL for numbers the kernel doesn't implement */
+    int flags;                   /* SYSCALL_* */
+    int stat_slot;               /* SYSCALL_STAT_* slot its calls are counted in */
+} syscall_entry_t;
+
+extern syscall_entry_t syscall_table[SYSCALL_TABLE_SIZE];
+extern syscall_stat_t syscall_stats[SYSCALL_STAT_SLOTS]; /* system-wide counters; per process ones are in the PCB */
+
+#endif // SYSCALL_H
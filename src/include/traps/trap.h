@@ -18,6 +18,8 @@ void TtyTrapTransmitHandler(UserContext* ctx);
 void TtyTrapReceiveHandler(UserContext* ctx);
 void DiskTrapHandler(UserContext* ctx);
 void NotImplementedTrapHandler(UserContext* ctx);
-void KernelTrapHandler(UserContext* ctx);
+void KernelTrapHandler(UserContext* ctx); // syscalls, see traps/syscall.c
+
+int CheckBuffer(void *addr, int len); // SUCCESS if [addr, addr+len) lies inside region 1
 
 #endif // TRAP_H
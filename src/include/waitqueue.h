@@ -0,0 +1,93 @@
+#ifndef WAITQUEUE_H
+#define WAITQUEUE_H
+
+#include "queue.h"
+
+/*
+ * A wait queue is the list of processes sleeping on one resource (a terminal, a
+ * process's children, a timer slot, the disk, ...). Each resource owns its own, so a
+ * wakeup only ever touches the processes sleeping on that resource. Sleepers are
+ * linked through their PCB (proc_list_t), so sleeping and waking never allocate.
+ */
+typedef struct wait_queue {
+    proc_list_t sleepers;
+    char *name;              /* for tracing */
+} wait_queue_t;
+
+/**
+ * ======================== Description =======================
+ * @brief Initializes an empty wait queue.
+ * ======================== Parameters ========================
+ * @param wq (wait_queue_t *): The wait queue.
+ * @param name (char *): Name used in trace messages.
+ * ======================== Returns ===========================
+ * @returns void
+ */
+void WaitQueueInit(wait_queue_t *wq, char *name);
+
+/**
+ * ======================== Description =======================
+ * @brief Blocks the current process on wq and switches to the next ready process. Returns once
+ *        somebody wakes it. The caller saves its user context first, as for any blocking call.
+ * ======================== Parameters ========================
+ * @param wq (wait_queue_t *): The wait queue to sleep on.
+ * ======================== Returns ===========================
+ * @returns void
+ */
+void WaitQueueSleep(wait_queue_t *wq);
+
+/**
+ * ======================== Description =======================
+ * @brief Wakes the process that has slept longest on wq.
+ * ======================== Parameters ========================
+ * @param wq (wait_queue_t *): The wait queue.
+ * ======================== Returns ===========================
+ * @returns The woken process, or NULL if nobody was sleeping.
+ */
+PCB *WaitQueueWakeOne(wait_queue_t *wq);
+
+/**
+ * ======================== Description =======================
+ * @brief Wakes every process sleeping on wq.
+ * ======================== Parameters ========================
+ * @param wq (wait_queue_t *): The wait queue.
+ * ======================== Returns ===========================
+ * @returns Number of processes woken.
+ */
+int WaitQueueWakeAll(wait_queue_t *wq);
+
+/**
+ * ======================== Description =======================
+ * @brief Wakes one particular process, in O(1), from whichever wait queue it sleeps on.
+ * ======================== Parameters ========================
+ * @param proc (PCB *): The sleeping process.
+ * ======================== Returns ===========================
+ * @returns void
+ */
+void WaitQueueWake(PCB *proc);
+
+/**
+ * ======================== Description =======================
+ * @brief Switches straight to a process just woken by a synchronous event (I/O completion,
+ *        a child exiting) instead of leaving it at the tail of its ready queue. The current
+ *        process is requeued if it can still run, or donates the rest of its slice if it is
+ *        blocking or exiting. Does nothing if the scheduling policy refuses the handoff
+ *        (SchedCanHandoff). The caller saves its user context first, as for any blocking call.
+ * ======================== Parameters ========================
+ * @param wakee (PCB *): A process returned by WaitQueueWakeOne; NULL does nothing.
+ * ======================== Returns ===========================
+ * @returns void
+ */
+void WaitQueueHandoff(PCB *wakee);
+
+/**
+ * ======================== Description =======================
+ * @brief Returns whether anybody is sleeping on wq.
+ * ======================== Parameters ========================
+ * @param wq (wait_queue_t *): The wait queue.
+ * ======================== Returns ===========================
+ * @returns 1 if wq has no sleepers, 0 otherwise.
+ */
+int WaitQueueIsEmpty(wait_queue_t *wq);
+
+#endif
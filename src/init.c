@@ -88,14 +88,24 @@ void InitializeFreeFrameList(int pmem_size) {
     int stack_base_pfn= DOWN_TO_PAGE(KERNEL_STACK_BASE) >> PAGESHIFT;
     int stack_limit_pfn = UP_TO_PAGE(KERNEL_STACK_LIMIT) >> PAGESHIFT;
 
-    for (int i = 0; i < nframes; i++) {
+    // Walk the frames from the top down so the free list hands out low pfns first
+    free_frame_head = -1;
+    for (int i = nframes - 1; i >= 0; i--) {
         frame_table[i].pfn = i;
+        frame_table[i].last_used_tick = 0;
+        frame_table[i].refcount = 0;
+        frame_table[i].next_free = -1;
+        frame_table[i].prev_free = -1;
+        frame_table[i].zeroed = 0;
+        frame_table[i].pinned = 0;
         if (i >= text_section_base_page && i < kernel_brk_pfn) {
             frame_table[i].usage = FRAME_KERNEL;
             frame_table[i].owner_pid = IDLE_PID;
+            frame_table[i].refcount = 1;
         } else {
             frame_table[i].usage = FRAME_FREE;
             frame_table[i].owner_pid = -1;
+            freeListPush(i);
             free_nframes += 1;
         }
     }
@@ -109,6 +119,7 @@ void InitializeProcTable(void) {
     
     // And set them all to NULL
     memset(proc_table, 0, sizeof(PCB*) * MAX_PROCS);
+    InitializePidIndex();
 }
 
 void InitializeInterruptVectorTable(void) {
@@ -119,6 +130,7 @@ void InitializeInterruptVectorTable(void) {
     TRAP_VECTOR[TRAP_TTY_TRANSMIT] = &TtyTrapTransmitHandler;
     TRAP_VECTOR[TRAP_MATH] = &MathTrapHandler;
     TRAP_VECTOR[TRAP_ILLEGAL] = &IllegalInstructionTrapHandler;
+    TRAP_VECTOR[TRAP_DISK] = &DiskTrapHandler;
     // TODO:
     // These are currently unimplemented (Checkpoint 2)
     // Add these in as they are implemented
@@ -130,20 +142,19 @@ void InitializeTerminals(void) {
     TracePrintf(0, "Kernel: Initializing terminals....\n");
     for (int i = 0; i < NUM_TERMINALS; i++) {
         terminals[i].tty_id = i;
-        terminals[i].blocked_readers = queueCreate();
-        terminals[i].blocked_writers = queueCreate();
-        if (terminals[i].blocked_readers == NULL || terminals[i].blocked_writers == NULL) {
-            TracePrintf(0, "Kernel: Failed to allocate memory for one of the queues in the %dth terminal.\n", i);
-            Halt();
-        }
+        WaitQueueInit(&terminals[i].blocked_readers, "tty readers");
+        WaitQueueInit(&terminals[i].blocked_writers, "tty writers");
+        WaitQueueInit(&terminals[i].write_done, "tty write done");
 
-        terminals[i].read_buffer = malloc(TERMINAL_MAX_LINE);
+        terminals[i].read_buffer = malloc(tty_input_size);
         if (terminals[i].read_buffer == NULL) {
             TracePrintf(0, "Kernel: Failed to allocate memory for read buffer for the %dth terminal.\n", i);
             Halt();
         }
 
-        terminals[i].read_buffer_len = 0;
+        terminals[i].read_head = 0;
+        terminals[i].read_tail = 0;
+        terminals[i].read_dropped = 0;
         terminals[i].write_buffer = NULL;
         terminals[i].write_buffer_position = 0;
         terminals[i].write_buffer_len = 0;
@@ -7,6 +7,12 @@
 #include "proc.h"
 #include "mem.h"
 #include "init.h"
+#include "image.h"
+#include "swap.h"
+#include "syscalls/tty.h"
+#include "sched.h"
+#include "timer.h"
+#include "slab.h"
 
 #include <fcntl.h>
 #include <unistd.h>
@@ -18,28 +24,41 @@ int is_vm_enabled;
 int kernel_brk_page;
 int text_section_base_page;
 int data_section_base_page;
-int LoadProgram(char *name, char *args[], PCB *proc);
-
-/* ================== Terminals ================== */
-#define NUM_TERMINALS 4
-#define TERMINAL_BUFFER_SIZE 1024
-typedef struct terminal {
-    int id;                        // terminal number (0–3)
-    char input_buffer[TERMINAL_BUFFER_SIZE];
-    int input_head;
-    int input_tail;
-    char output_buffer[TERMINAL_BUFFER_SIZE];
-    int output_head;
-    int output_tail;
-    int transmitting;              // flag: is a transmission in progress?
-    PCB *waiting_read_proc;      // process blocked on reading
-    PCB *waiting_write_proc;     // process blocked on writing
-} terminal_t;
-
-/* ==================== Helpers =================== */
 
-void CloneFrame(int pfn1, int pfn2);
+// Kernel boot options
+int lazy_load_enabled = 0;
+int LoadProgram(char *name, char *args[], PCB *proc);
 
+char **ParseKernelOptions(char **cmd_args) {
+    int i = 0;
+    while (cmd_args[i] != NULL && strchr(cmd_args[i], '=') != NULL) {
+        char *opt = cmd_args[i];
+        if (strncmp(opt, "swap=", 5) == 0) {
+            swap_enabled = atoi(opt + 5);
+            TracePrintf(1, "KernelStart: Swapping to disk %s\n", swap_enabled ? "enabled" : "disabled");
+        } else if (strncmp(opt, "quantum=", 8) == 0) {
+            int quantum = atoi(opt + 8);
+            if (quantum >= 1 && quantum <= SCHED_MAX_QUANTUM) {
+                default_quantum = quantum;
+            }
+            TracePrintf(1, "KernelStart: Base time slice is %d ticks\n", default_quantum);
+        } else if (strncmp(opt, "sched=", 6) == 0) {
+            if (SchedSelectPolicy(opt + 6) == ERROR) {
+                TracePrintf(0, "KernelStart: Unknown scheduling policy '%s', keeping %s\n", opt + 6, sched_ops->name);
+            }
+        } else if (strncmp(opt, "ttybuf=", 7) == 0) {
+            tty_input_size = TtyInputRoundSize(atoi(opt + 7));
+            TracePrintf(1, "KernelStart: Terminal input rings are %d bytes\n", tty_input_size);
+        } else if (strncmp(opt, "lazy=", 5) == 0) {
+            lazy_load_enabled = atoi(opt + 5);
+            TracePrintf(1, "KernelStart: Demand-paged program loading %s\n", lazy_load_enabled ? "enabled" : "disabled");
+        } else {
+            TracePrintf(0, "KernelStart: Ignoring unknown kernel option '%s'\n", opt);
+        }
+        i++;
+    }
+    return &cmd_args[i];
+}
 
 void KernelStart(char **cmd_args, unsigned int pmem_size, UserContext *uctxt)
 {
@@ -47,6 +66,7 @@ void KernelStart(char **cmd_args, unsigned int pmem_size, UserContext *uctxt)
     TracePrintf(1, "Physical memory has size %d\n", pmem_size);
 
     kernel_brk_page = _orig_kernel_brk_page;
+    char **prog_args = ParseKernelOptions(cmd_args);
 
     TracePrintf(1, "Initializing the free frame array...\n");
     InitializeFreeFrameList(pmem_size);
@@ -65,9 +85,17 @@ void KernelStart(char **cmd_args, unsigned int pmem_size, UserContext *uctxt)
 
     TracePrintf(1, "Initializing process queues (ready, blocked, zombie)....\n");
     InitializeProcQueues();
+    InitializeScheduler();
+    InitializeTimerWheel();
+
+    if (swap_enabled) {
+        TracePrintf(1, "Initializing the swap area on disk....\n");
+        InitializeSwap();
+    }
     WriteRegister(REG_PTBR0, (unsigned int)pt_region0);
     WriteRegister(REG_PTLR0, MAX_PT_LEN);
     WriteRegister(REG_VM_ENABLE, 1);
+    is_vm_enabled = 1;
 
  
     idle_proc = CreateIdlePCB(uctxt);
@@ -82,9 +110,13 @@ void KernelStart(char **cmd_args, unsigned int pmem_size, UserContext *uctxt)
        TracePrintf(0, "Failed to create the init process pdb.\n");
     }
     init_proc->kstack = InitializeKernelStackProcess();
+    if (init_proc->kstack == NULL) {
+       TracePrintf(0, "KernelStart: Failed to allocate the init process kernel stack.\n");
+       Halt();
+    }
     memcpy(&(init_proc->user_context), uctxt, sizeof(UserContext));
 
-    char *name = (cmd_args[0] == NULL) ? "./user/init" : cmd_args[0];
+    char *name = (prog_args[0] == NULL) ? "./user/init" : prog_args[0];
 
     TracePrintf(0, "Loading program into init proccess. Switching registers for region1 of page table and flushing TLB entries!\n");
     WriteRegister(REG_PTBR1, (unsigned int)init_proc->ptbr);
@@ -93,7 +125,7 @@ void KernelStart(char **cmd_args, unsigned int pmem_size, UserContext *uctxt)
 
     // Now, load the program text data and stack into init_proc process control block
 
-    int load_status = LoadProgram(name, cmd_args, init_proc);
+    int load_status = LoadProgram(name, prog_args, init_proc);
 
     if (load_status != SUCCESS) {
       TracePrintf(0, "KernelStart: Failed to load program %s!\n", name);
@@ -107,7 +139,7 @@ void KernelStart(char **cmd_args, unsigned int pmem_size, UserContext *uctxt)
     WriteRegister(REG_TLB_FLUSH, TLB_FLUSH_ALL); // Flushing TLB from any stale mappings
 
     // Add the init process to the ready queue to be scheduled to run by the scheduler
-    queueEnqueue(ready_queue, init_proc); // pid 0 running and only pid 1 in there
+    SchedReady(init_proc); // pid 0 running and only pid 1 in there
     // Now copy kernel context into init process
     KernelContextSwitch(KCCopy, init_proc, NULL);
     memcpy(uctxt, &current_process->user_context, sizeof(UserContext));
@@ -122,6 +154,7 @@ KernelContext *KCSwitch(KernelContext *kc_in, void *curr_pcb_p, void *next_pcb_p
     if (curr) {
     // If there is no current process, the context doesn't get saved :(
         memcpy(&(curr->kernel_context), kc_in, sizeof(KernelContext));
+        curr->switches_out++;
     }
 
     // Switch kernel stacks in region 0 from current process to next process
@@ -161,13 +194,13 @@ KernelContext *KCCopy(KernelContext *kc_in, void *new_pcb_p, void *unused){
         pcb_new->kstack = kstack_new;
     }
 
-    // Copying the contents of the current process kernel stack into the child process
+    // Copying the contents of the current process kernel stack into the child process in one batch
+    frame_copy_t copies[KSTACK_PAGES];
     for (int i = 0; i < KSTACK_PAGES; i++) {
-        int pfn_parent = current_process->kstack[i].pfn;
-        int pfn_child = kstack_new[i].pfn;
-
-        CloneFrame(pfn_parent, pfn_child);
+        copies[i].pfn_src = current_process->kstack[i].pfn;
+        copies[i].pfn_dst = kstack_new[i].pfn;
     }
+    CloneFrames(copies, KSTACK_PAGES);
     
     // In case the CPU switches to the new process after returning. We don't want it to use old kstack mappings
     WriteRegister(REG_TLB_FLUSH, TLB_FLUSH_KSTACK); 
@@ -178,9 +211,7 @@ KernelContext *KCCopy(KernelContext *kc_in, void *new_pcb_p, void *unused){
 
 void scheduler() {
     // while true:
-    //     next = queueDequeue(ready_queue)
-    //     if next == NULL:
-    //         next = idle_pcb  // run idle if no ready processes
+    //     next = SchedPickNext()  // idle_pcb if no ready processes
 
     //     rc = KernelContextSwitch(KCSwitch, current, next)
 
@@ -217,10 +248,14 @@ pte_t *InitializeKernelStackProcess(void) {
         return NULL;
     }
     for (int i = 0; i < KSTACK_PAGES; i++) {
-        int pfn = allocFrame(FRAME_KERNEL, -1);
+        int pfn = allocFrameEvict(FRAME_KERNEL, -1);
         if (pfn == -1) {
             TracePrintf(0, "InitializeKernelStackProcess: Failed to allocate frame for kernel stack.\n");
-            Halt();
+            for (int j = 0; j < i; j++) {
+                freeFrame(kernel_stack[j].pfn);
+            }
+            free(kernel_stack);
+            return NULL;
         }
         kernel_stack[i].valid = 1;
         kernel_stack[i].pfn = pfn;
@@ -240,10 +275,9 @@ int SetKernelBrk(void *addr_ptr)
     unsigned int target_vaddr = UP_TO_PAGE((unsigned int) addr_ptr);
     unsigned int target_vpn  = target_vaddr >> PAGESHIFT;
 
-    /* bounds: cannot grow into kernel stack (stack base is virtual address) */
-    unsigned int stack_base_vpn = DOWN_TO_PAGE(KERNEL_STACK_BASE) >> PAGESHIFT;
-    if (target_vpn >= stack_base_vpn) {
-        TracePrintf(0, "SetKernelBrk: target collides with kernel stack\n");
+    /* bounds: cannot grow into the slab area, which sits below the scratch window and kernel stack */
+    if (target_vpn > (unsigned int) slab_low_page) {
+        TracePrintf(0, "SetKernelBrk: target collides with slab area / kernel stack\n");
         return -1;
     }
 
@@ -434,6 +468,14 @@ LoadProgram(char *name, char *args[], PCB *proc)
     cp2 += strlen(cp2) + 1;
   }
 
+  /*
+   * Look the executable up in the image cache before the old address space
+   * goes away (the name may live in it). If another process already runs
+   * it, we map its text frames instead of loading our own.
+   */
+  exec_image_t *image = ImageAcquire(name, fd, &li);
+  int text_shared = ImageTextLoaded(image);
+
   /*
    * Set up the page tables for the process so that we can read the
    * program into memory.  Get the right number of physical pages
@@ -445,13 +487,9 @@ LoadProgram(char *name, char *args[], PCB *proc)
    * ==>> for every valid page, free the pfn and mark the page invalid.
    */
   TracePrintf(0, "LoadProgram: Throwing away old region 1 mappings and freeing allocated frames.\n");
+  FreeRegion1(proc);
   pte_t *pt_region1 = proc->ptbr;
-  for (int vpn = 0; vpn < MAX_PT_LEN; vpn++) {
-    if (pt_region1[vpn].valid == 1) {
-        freeFrame(pt_region1[vpn].pfn);
-        pt_region1[vpn].valid = 0;
-    }
-  }
+  proc->image = image;
 
   /*
    * ==>> Then, build up the new region1.  
@@ -464,9 +502,49 @@ LoadProgram(char *name, char *args[], PCB *proc)
    * ==>> These pages should be marked valid, with a protection of
    * ==>> (PROT_READ | PROT_WRITE).
    */
+  if (lazy_load_enabled) {
+    /*
+     * Demand paging: leave text and data unmapped and just record where each
+     * page comes from. MemoryTrapHandler calls LoadLazyPage on first touch.
+     */
+    TracePrintf(0, "LoadProgram: Deferring %d text and %d data pages until first touch.\n", li.t_npg, data_npg);
+    for (int i = 0; i < li.t_npg && !text_shared; i++) {
+      proc->page_flags[text_pg1 + i] = PAGE_LAZY;
+      proc->page_backing[text_pg1 + i].file_offset = li.t_faddr + (i << PAGESHIFT);
+      proc->page_backing[text_pg1 + i].file_len = PAGESIZE;
+      proc->page_backing[text_pg1 + i].prot = PROT_READ | PROT_EXEC;
+    }
+    for (int i = 0; i < data_npg; i++) {
+      unsigned int page_vaddr = li.id_vaddr + (i << PAGESHIFT);
+      int file_len = 0;
+      if (page_vaddr < li.id_end) {
+        file_len = (li.id_end - page_vaddr > PAGESIZE) ? PAGESIZE : li.id_end - page_vaddr;
+      }
+      proc->page_flags[data_pg1 + i] = PAGE_LAZY;
+      proc->page_backing[data_pg1 + i].file_offset = li.id_faddr + (i << PAGESHIFT);
+      proc->page_backing[data_pg1 + i].file_len = file_len;
+      proc->page_backing[data_pg1 + i].prot = PROT_READ | PROT_WRITE;
+    }
+  }
+
+  if (text_shared) {
+    TracePrintf(0, "LoadProgram: Mapping %d shared text frames of cached image.\n", li.t_npg);
+    for (int i = 0; i < li.t_npg; i++) {
+      int pfn = image->text_pfns[i];
+      frameRef(pfn);
+      MapPage(pt_region1, text_pg1 + i, pfn, PROT_READ | PROT_EXEC);
+    }
+  }
+
   TracePrintf(0, "LoadProgram: Allocating %d frames for text segment.\n", li.t_npg);
-  for (int i = 0; i < li.t_npg; i++) {
-    int pfn = allocFrame(FRAME_USER, proc->pid);
+  for (int i = 0; i < li.t_npg && !lazy_load_enabled && !text_shared; i++) {
+    int pfn = allocFrameEvict(FRAME_USER, proc->pid);
+    if (pfn == -1) {
+      TracePrintf(0, "LoadProgram: Ran out of frames loading a program into process PID %d.\n", proc->pid);
+      close(fd);
+      free(argbuf);
+      return KILL;
+    }
     pt_region1[text_pg1 + i].pfn = pfn;
     pt_region1[text_pg1 + i].valid = 1;
     pt_region1[text_pg1 + i].prot = PROT_READ | PROT_WRITE;
@@ -480,8 +558,14 @@ LoadProgram(char *name, char *args[], PCB *proc)
    * ==>> (PROT_READ | PROT_WRITE).
    */
   TracePrintf(0, "LoadProgram: Allocating %d frames for data segment.\n", data_npg);
-  for (int i = 0; i < data_npg; i++) {
-    int pfn = allocFrame(FRAME_USER, proc->pid);
+  for (int i = 0; i < data_npg && !lazy_load_enabled; i++) {
+    int pfn = allocFrameEvict(FRAME_USER, proc->pid);
+    if (pfn == -1) {
+      TracePrintf(0, "LoadProgram: Ran out of frames loading a program into process PID %d.\n", proc->pid);
+      close(fd);
+      free(argbuf);
+      return KILL;
+    }
     pt_region1[data_pg1 + i].pfn = pfn;
     pt_region1[data_pg1 + i].valid = 1;
     pt_region1[data_pg1 + i].prot = PROT_READ | PROT_WRITE;
@@ -497,7 +581,13 @@ LoadProgram(char *name, char *args[], PCB *proc)
   TracePrintf(0, "LoadProgram: Allocating %d frames for the stack.\n", stack_npg);
   int stack_base = proc->ptlr - stack_npg;
   for (int i = 0; i < stack_npg; i++) {
-    int pfn = allocFrame(FRAME_USER, proc->pid);
+    int pfn = allocZeroedFrame(FRAME_USER, proc->pid);
+    if (pfn == -1) {
+      TracePrintf(0, "LoadProgram: Ran out of frames loading a program into process PID %d.\n", proc->pid);
+      close(fd);
+      free(argbuf);
+      return KILL;
+    }
     pt_region1[stack_base + i].pfn = pfn;
     pt_region1[stack_base + i].valid = 1;
     pt_region1[stack_base + i].prot = PROT_READ | PROT_WRITE;
@@ -512,14 +602,22 @@ LoadProgram(char *name, char *args[], PCB *proc)
    * All pages for the new address space are now in the page table.  
    */
 
+  if (lazy_load_enabled) {
+    proc->exec_fd = fd;     /* keep the image open to back the lazy pages */
+    goto build_stack;
+  }
+
   /*
    * Read the text from the file into memory.
    */
-  lseek(fd, li.t_faddr, SEEK_SET);
-  segment_size = li.t_npg << PAGESHIFT;
-  if (read(fd, (void *) li.t_vaddr, segment_size) != segment_size) {
-    close(fd);
-    return KILL;   // see ykernel.h
+  if (!text_shared) {
+    lseek(fd, li.t_faddr, SEEK_SET);
+    segment_size = li.t_npg << PAGESHIFT;
+    if (read(fd, (void *) li.t_vaddr, segment_size) != segment_size) {
+      close(fd);
+      free(argbuf);
+      return KILL;   // see ykernel.h
+    }
   }
 
   /*
@@ -530,6 +628,7 @@ LoadProgram(char *name, char *args[], PCB *proc)
 
   if (read(fd, (void *) li.id_vaddr, segment_size) != segment_size) {
     close(fd);
+    free(argbuf);
     return KILL;
   }
 
@@ -550,6 +649,7 @@ LoadProgram(char *name, char *args[], PCB *proc)
    */
   for (int i = 0; i < li.t_npg; i++) {
     pt_region1[text_pg1 + i].prot = PROT_READ | PROT_EXEC;
+    ImagePublishTextPage(image, i, pt_region1[text_pg1 + i].pfn); /* no-op if already shared */
   }
     WriteRegister(REG_TLB_FLUSH, TLB_FLUSH_1);
 
@@ -559,6 +659,7 @@ LoadProgram(char *name, char *args[], PCB *proc)
    */
   bzero((void *)li.id_end, li.ud_end - li.id_end);
 
+build_stack:
 
   /*
    * Set the entry point in the process's UserContext
@@ -570,8 +671,9 @@ LoadProgram(char *name, char *args[], PCB *proc)
     (proc->user_context).pc = (caddr_t) li.entry;
 
 
-    proc->user_heap_start_vaddr = (unsigned int) ((data_pg1 << PAGESHIFT) + VMEM_1_BASE); // Heap starts after end of data segment
-    proc->user_heap_end_vaddr = (unsigned int)  ((data_pg1 << PAGESHIFT) + VMEM_1_BASE);
+    // Heap starts after end of data segment (lazy data pages are unmapped, so the brk must not start inside them)
+    proc->user_heap_start_vaddr = (unsigned int) (((data_pg1 + data_npg) << PAGESHIFT) + VMEM_1_BASE);
+    proc->user_heap_end_vaddr = (unsigned int)  (((data_pg1 + data_npg) << PAGESHIFT) + VMEM_1_BASE);
     proc->user_stack_base_vaddr = (unsigned int)((stack_base << PAGESHIFT) + VMEM_1_BASE);
 
   /*
@@ -598,3 +700,55 @@ LoadProgram(char *name, char *args[], PCB *proc)
   return SUCCESS;
 }
 
+int LoadLazyPage(PCB *proc, int vpn) {
+    if (vpn < 0 || vpn >= MAX_PT_LEN || !(proc->page_flags[vpn] & PAGE_LAZY)) {
+        return ERROR;
+    }
+    page_backing_t *backing = &proc->page_backing[vpn];
+    unsigned int vaddr = (vpn << PAGESHIFT) + VMEM_1_BASE;
+
+    // Text pages another process already loaded are just mapped from the image cache
+    exec_image_t *image = proc->image;
+    int text_page = (image != NULL) ? vpn - image->text_pg1 : -1;
+    if (image == NULL || text_page >= image->text_npg) {
+        text_page = -1;
+    }
+    if (text_page >= 0 && image->text_pfns[text_page] != -1) {
+        frameRef(image->text_pfns[text_page]);
+        MapPage(proc->ptbr, vpn, image->text_pfns[text_page], backing->prot);
+        proc->page_flags[vpn] &= ~PAGE_LAZY;
+        WriteRegister(REG_TLB_FLUSH, vaddr);
+        return SUCCESS;
+    }
+
+    int pfn = allocFrameEvict(FRAME_USER, proc->pid);
+    if (pfn == -1) {
+        TracePrintf(0, "LoadLazyPage: Out of frames loading page %d for process PID %d!\n", vpn, proc->pid);
+        return ERROR;
+    }
+
+    // Map it writable first so we can fill it through its own user address
+    MapPage(proc->ptbr, vpn, pfn, PROT_READ | PROT_WRITE);
+    WriteRegister(REG_TLB_FLUSH, vaddr);
+
+    if (backing->file_len > 0) {
+        if (lseek(proc->exec_fd, backing->file_offset, SEEK_SET) < 0 ||
+            read(proc->exec_fd, (void *)vaddr, backing->file_len) != backing->file_len) {
+            TracePrintf(0, "LoadLazyPage: Failed to read page %d of process PID %d from its executable!\n", vpn, proc->pid);
+            proc->ptbr[vpn].valid = 0;
+            WriteRegister(REG_TLB_FLUSH, vaddr);
+            freeFrame(pfn);
+            return ERROR;
+        }
+    }
+    memset((void *)(vaddr + backing->file_len), 0, PAGESIZE - backing->file_len);
+
+    proc->ptbr[vpn].prot = backing->prot;
+    proc->page_flags[vpn] &= ~PAGE_LAZY;
+    WriteRegister(REG_TLB_FLUSH, vaddr);
+    if (text_page >= 0) {
+        ImagePublishTextPage(image, text_page, pfn);
+    }
+    TracePrintf(1, "LoadLazyPage: Loaded page %d for process PID %d into pfn %d.\n", vpn, proc->pid, pfn);
+    return SUCCESS;
+}
@@ -2,6 +2,10 @@
 #include "hardware.h"
 #include "mem.h"
 #include "kernel.h"
+#include "swap.h"
+#include "traps/trap.h"
+#include "image.h"
+#include <unistd.h>
 
 // Defining variables for the free frames list
 int nframes;
@@ -11,16 +15,116 @@ frame_desc_t *frame_table;
 // Defining the global region 0 page table array
 pte_t pt_region0[MAX_PT_LEN];
 
+int free_frame_head = -1;
+
+// Free frames that the idle process has already zeroed. They are still free (and counted in
+// free_nframes) but live on their own list so zero-fill requests can skip the memset.
+int zeroed_frame_head = -1;
+int zeroed_nframes;
+unsigned int zero_pool_hits;
+unsigned int zero_pool_misses;
+
+void freeListPush(int pfn) {
+    frame_table[pfn].prev_free = -1;
+    frame_table[pfn].next_free = free_frame_head;
+    if (free_frame_head != -1) {
+        frame_table[free_frame_head].prev_free = pfn;
+    }
+    free_frame_head = pfn;
+}
+
+static void zeroedListPush(int pfn) {
+    frame_table[pfn].zeroed = 1;
+    frame_table[pfn].prev_free = -1;
+    frame_table[pfn].next_free = zeroed_frame_head;
+    if (zeroed_frame_head != -1) {
+        frame_table[zeroed_frame_head].prev_free = pfn;
+    }
+    zeroed_frame_head = pfn;
+    zeroed_nframes++;
+}
+
+// Unlinks a free frame from whichever list (plain or pre-zeroed) it is on
+static void freeListUnlink(int pfn) {
+    int *head = &free_frame_head;
+    if (frame_table[pfn].zeroed) {
+        head = &zeroed_frame_head;
+        frame_table[pfn].zeroed = 0;
+        zeroed_nframes--;
+    }
+    int prev = frame_table[pfn].prev_free;
+    int next = frame_table[pfn].next_free;
+    if (prev == -1) *head = next;
+    else frame_table[prev].next_free = next;
+    if (next != -1) frame_table[next].prev_free = prev;
+    frame_table[pfn].next_free = -1;
+    frame_table[pfn].prev_free = -1;
+}
+
 int allocFrame(frame_usage_t usage, int owner_pid) {
-    for (int i = 0; i < (int)nframes; i++) {
-        if (frame_table[i].usage == FRAME_FREE) {
-            frame_table[i].usage = usage;
-            frame_table[i].owner_pid = -1;
-            if (free_nframes > 0) free_nframes--;
-            return i;
+    // Callers that don't need zeroes take plain frames first and leave the zeroed pool alone
+    int pfn = (free_frame_head != -1) ? free_frame_head : zeroed_frame_head;
+    if (pfn == -1) {
+        return -1;
+    }
+    freeListUnlink(pfn);
+    frame_table[pfn].usage = usage;
+    frame_table[pfn].owner_pid = owner_pid;
+    frame_table[pfn].refcount = 1;
+    frame_table[pfn].referenced = 1;
+    frame_table[pfn].last_used_tick = tick_count;
+    free_nframes--;
+    return pfn;
+}
+
+int allocFrameEvict(frame_usage_t usage, int owner_pid) {
+    int pfn = allocFrame(usage, owner_pid);
+    while (pfn == -1) {
+        if (SwapEvictOne() == ERROR) {
+            return -1;
         }
+        // Someone else may grab the frame while we sleep on the disk, so just try again
+        pfn = allocFrame(usage, owner_pid);
+    }
+    return pfn;
+}
+
+int allocZeroedFrame(frame_usage_t usage, int owner_pid) {
+    int pfn = zeroed_frame_head;
+    if (pfn != -1) {
+        zero_pool_hits++;
+        freeListUnlink(pfn);
+        frame_table[pfn].usage = usage;
+        frame_table[pfn].owner_pid = owner_pid;
+        frame_table[pfn].refcount = 1;
+        frame_table[pfn].referenced = 1;
+        frame_table[pfn].last_used_tick = tick_count;
+        free_nframes--;
+        return pfn;
+    }
+
+    // Pool is empty, so pay for the memset here
+    zero_pool_misses++;
+    pfn = allocFrameEvict(usage, owner_pid);
+    if (pfn != -1) {
+        ZeroFrame(pfn);
+    }
+    return pfn;
+}
+
+void RefillZeroPool(int budget) {
+    int refilled = 0;
+    while (budget-- > 0 && zeroed_nframes < ZERO_POOL_TARGET && free_frame_head != -1) {
+        int pfn = free_frame_head;
+        freeListUnlink(pfn);
+        ZeroFrame(pfn);
+        zeroedListPush(pfn);
+        refilled++;
+    }
+    if (refilled > 0) {
+        TracePrintf(1, "RefillZeroPool: Zeroed %d frames, %d in the pool (hits %u, misses %u)\n",
+                    refilled, zeroed_nframes, zero_pool_hits, zero_pool_misses);
     }
-    return -1;
 }
 
 int allocSpecificFrame(int pfn, frame_usage_t usage, int owner_pid) {
@@ -32,9 +136,11 @@ int allocSpecificFrame(int pfn, frame_usage_t usage, int owner_pid) {
         TracePrintf(0, "allocSpecificFrame: This frame is already in use.\n");
         return -1;
     }
+    freeListUnlink(pfn);
     frame_table[pfn].usage = usage;
-    frame_table[pfn].owner_pid = -1;
-    if (free_nframes > 0) free_nframes--;
+    frame_table[pfn].owner_pid = owner_pid;
+    frame_table[pfn].refcount = 1;
+    free_nframes--;
     
     return pfn;
 }
@@ -44,11 +150,31 @@ void freeFrame(int pfn) {
         TracePrintf(0, "freeFrame: invalid pfn %d\n", pfn);
         return;
     }
+    if (frame_table[pfn].usage == FRAME_FREE) {
+        TracePrintf(0, "freeFrame: pfn %d is already free\n", pfn);
+        return;
+    }
+    // Shared frames only go back on the free list once the last mapping drops them
+    if (--frame_table[pfn].refcount > 0) {
+        return;
+    }
+    frame_table[pfn].refcount = 0;
     frame_table[pfn].usage = FRAME_FREE;
     frame_table[pfn].owner_pid = -1;
+    freeListPush(pfn);
     free_nframes++;
 }
 
+void frameRef(int pfn) {
+    if (!valid_pfn(pfn) || frame_table[pfn].usage == FRAME_FREE) {
+        TracePrintf(0, "frameRef: pfn %d is not allocated\n", pfn);
+        return;
+    }
+    frame_table[pfn].refcount++;
+    frame_table[pfn].referenced = 1;
+    frame_table[pfn].last_used_tick = tick_count;
+}
+
 void MapPage(pte_t *ptbr, int vpn, int pfn, int prot) {
     ptbr[vpn].pfn = pfn;
     ptbr[vpn].prot = prot;
@@ -87,85 +213,297 @@ void UnmapRegion0(unsigned int vpn) {
     pt_region0[vpn].pfn   = 0;
 }
 
-// void CloneFrame(int pfn_src, int pfn_dst) {
-//     // Map a scratch page to pfn_dst
-//     int scratch_page = SCRATCH_ADDR >> PAGESHIFT;
-//     pt_region0[scratch_page].pfn = pfn_dst;
-//     pt_region0[scratch_page].prot = PROT_READ | PROT_WRITE;
-//     pt_region0[scratch_page].valid = 1;
-//     WriteRegister(REG_TLB_FLUSH, SCRATCH_ADDR); // In case the CPU already has a mapping in the TLB
+// Points one scratch window page at a frame. Does not flush; the caller does, once for everything it mapped
+static void setScratchPte(unsigned int addr, int pfn, int prot) {
+    int vpn = addr >> PAGESHIFT;
+    pt_region0[vpn].pfn = pfn;
+    pt_region0[vpn].prot = prot;
+    pt_region0[vpn].valid = 1;
+}
 
-//     // Copy the contents of pfn_src to the frame mapped by the page table to pfn_dst
-//     unsigned int pfn_src_addr = pfn_src << PAGESHIFT;
-//     memcpy((void *)(SCRATCH_ADDR), (void *)pfn_src_addr, PAGESIZE);
+static void clearScratchPte(unsigned int addr) {
+    int vpn = addr >> PAGESHIFT;
+    pt_region0[vpn].valid = 0;
+    pt_region0[vpn].prot = 0;
+    pt_region0[vpn].pfn = 0;
+}
 
-//     // Now that the frame pfn_dst has the contents of the frame pfn_src, unmap it from the scratch address in pt_region0
-//     pt_region0[scratch_page].valid = 0;
-//     pt_region0[scratch_page].prot = 0;
-//     pt_region0[scratch_page].pfn = 0;
-//     WriteRegister(REG_TLB_FLUSH, SCRATCH_ADDR);
-// }
+// Single page users of the window map one page, use it and unmap it again right away
+static void MapScratchPage(unsigned int addr, int pfn, int prot) {
+    setScratchPte(addr, pfn, prot);
+    WriteRegister(REG_TLB_FLUSH, addr);
+}
 
-void CloneFrame(int pfn_src, int pfn_dst) {
-    // 1. Get VPNs for both scratch pages
-    int scratch_vpn_dst = SCRATCH_ADDR_DST >> PAGESHIFT;
-    int scratch_vpn_src = SCRATCH_ADDR_SRC >> PAGESHIFT;
+static void UnmapScratchPage(unsigned int addr) {
+    clearScratchPte(addr);
+    WriteRegister(REG_TLB_FLUSH, addr);
+}
 
-    // 2. Map the source frame to the source scratch page
-    pt_region0[scratch_vpn_src].pfn = pfn_src;
-    pt_region0[scratch_vpn_src].prot = PROT_READ; // Read-only
-    pt_region0[scratch_vpn_src].valid = 1;
+void CloneFrames(frame_copy_t *copies, int n) {
+    if (n <= 0) {
+        return;
+    }
+    for (int batch = 0; batch < n; batch += SCRATCH_PAIRS) {
+        int batch_len = (n - batch < SCRATCH_PAIRS) ? n - batch : SCRATCH_PAIRS;
 
-    // 3. Map the destination frame to the destination scratch page
-    pt_region0[scratch_vpn_dst].pfn = pfn_dst;
-    pt_region0[scratch_vpn_dst].prot = PROT_READ | PROT_WRITE;
-    pt_region0[scratch_vpn_dst].valid = 1;
+        // Write the whole batch's PTEs, flush once, then copy
+        for (int i = 0; i < batch_len; i++) {
+            setScratchPte(SCRATCH_ADDR_SRC(i), copies[batch + i].pfn_src, PROT_READ);
+            setScratchPte(SCRATCH_ADDR_DST(i), copies[batch + i].pfn_dst, PROT_READ | PROT_WRITE);
+        }
+        WriteRegister(REG_TLB_FLUSH, TLB_FLUSH_0);
+        for (int i = 0; i < batch_len; i++) {
+            memcpy((void *)SCRATCH_ADDR_DST(i), (void *)SCRATCH_ADDR_SRC(i), PAGESIZE);
+        }
+    }
 
-    // 4. Flush the TLB for both virtual addresses
-    WriteRegister(REG_TLB_FLUSH, SCRATCH_ADDR_SRC);
-    WriteRegister(REG_TLB_FLUSH, SCRATCH_ADDR_DST);
+    // Don't leave the window pointing at frames that may be freed and handed out again
+    for (int i = 0; i < SCRATCH_PAIRS; i++) {
+        clearScratchPte(SCRATCH_ADDR_SRC(i));
+        clearScratchPte(SCRATCH_ADDR_DST(i));
+    }
+    WriteRegister(REG_TLB_FLUSH, TLB_FLUSH_0);
+}
 
-    // 5. Now, memcpy between the two VALID VIRTUAL addresses
-    memcpy((void *)SCRATCH_ADDR_DST, (void *)SCRATCH_ADDR_SRC, PAGESIZE);
+void ReadFrame(int pfn, void *buf) {
+    MapScratchPage(SCRATCH_ADDR_SRC(0), pfn, PROT_READ);
+    memcpy(buf, (void *)SCRATCH_ADDR_SRC(0), PAGESIZE);
+    UnmapScratchPage(SCRATCH_ADDR_SRC(0));
+}
 
-    // 6. Unmap both scratch pages
-    pt_region0[scratch_vpn_src].valid = 0;
-    pt_region0[scratch_vpn_dst].valid = 0;
+void WriteFrame(int pfn, void *buf) {
+    MapScratchPage(SCRATCH_ADDR_DST(0), pfn, PROT_READ | PROT_WRITE);
+    memcpy((void *)SCRATCH_ADDR_DST(0), buf, PAGESIZE);
+    UnmapScratchPage(SCRATCH_ADDR_DST(0));
+}
 
-    // 7. Flush the TLB again
-    WriteRegister(REG_TLB_FLUSH, SCRATCH_ADDR_SRC);
-    WriteRegister(REG_TLB_FLUSH, SCRATCH_ADDR_DST);
+void ZeroFrame(int pfn) {
+    MapScratchPage(SCRATCH_ADDR_DST(0), pfn, PROT_READ | PROT_WRITE);
+    memset((void *)SCRATCH_ADDR_DST(0), 0, PAGESIZE);
+    UnmapScratchPage(SCRATCH_ADDR_DST(0));
+}
+
+int CopyToProcess(PCB *proc, void *addr, void *src, int len) {
+    if (len <= 0) {
+        return SUCCESS;
+    }
+    unsigned int start = (unsigned int)addr;
+    int first_vpn = (DOWN_TO_PAGE(start) - VMEM_1_BASE) >> PAGESHIFT;
+    int last_vpn = (DOWN_TO_PAGE(start + len - 1) - VMEM_1_BASE) >> PAGESHIFT;
+    for (int vpn = first_vpn; vpn <= last_vpn; vpn++) {
+        if (vpn < 0 || vpn >= MAX_PT_LEN || proc->ptbr[vpn].valid == 0 || !(proc->ptbr[vpn].prot & PROT_WRITE) ||
+            (proc->page_flags[vpn] & PAGE_COW)) {
+            return ERROR;
+        }
+    }
+
+    char *from = (char *)src;
+    while (len > 0) {
+        int vpn = (DOWN_TO_PAGE(start) - VMEM_1_BASE) >> PAGESHIFT;
+        int offset = start & PAGEOFFSET;
+        int chunk = (len < PAGESIZE - offset) ? len : PAGESIZE - offset;
+        MapScratchPage(SCRATCH_ADDR_DST(0), proc->ptbr[vpn].pfn, PROT_READ | PROT_WRITE);
+        memcpy((char *)SCRATCH_ADDR_DST(0) + offset, from, chunk);
+        UnmapScratchPage(SCRATCH_ADDR_DST(0));
+        frame_table[proc->ptbr[vpn].pfn].referenced = 1;
+        start += chunk;
+        from += chunk;
+        len -= chunk;
+    }
+    return SUCCESS;
+}
+
+void CloneFrame(int pfn_src, int pfn_dst) {
+    frame_copy_t copy = { pfn_src, pfn_dst };
+    CloneFrames(&copy, 1);
+}
+
+void FreeRegion1(PCB *proc) {
+    pte_t *pt_region1 = proc->ptbr;
+    for (int vpn = 0; vpn < MAX_PT_LEN; vpn++) {
+        if (pt_region1[vpn].valid == 1) {
+            freeFrame(pt_region1[vpn].pfn);
+            pt_region1[vpn].valid = 0;
+        } else if (proc->page_flags[vpn] & PAGE_SWAPPED) {
+            SwapFreeSlot(pt_region1[vpn].pfn);
+        }
+        proc->page_flags[vpn] = 0;
+    }
+    if (proc->exec_fd >= 0) {
+        close(proc->exec_fd);   /* the old image no longer backs any page */
+        proc->exec_fd = -1;
+    }
+    ImageRelease(proc->image);  /* its text is unmapped now */
+    proc->image = NULL;
 }
 
 int CopyPT(PCB *src, PCB *dst) {
     /**
-     * For each valid page table entry i in pt_src, allocate a frame for pt_dst
-     * Copy the content of the frame pt_src[i].pfn to pt_dst[i].pfn.
-     * Set protections to be the same as thos of pt_src[i]
+     * For each valid page table entry i in pt_src, share its frame with pt_dst instead of copying it.
+     * Writable pages become read-only on both sides and are marked copy-on-write, so the first
+     * write from either process faults into MemoryTrapHandler which calls BreakCOW().
+     * PAGE_SHARED pages (Shared_Pages) keep their write permission and stay shared.
      * 
     */
 
     pte_t *pt_src = src->ptbr;
     pte_t *pt_dst = dst->ptbr;
     for (int i = 0; i < MAX_PT_LEN; i++) {
+        if (src->page_flags[i] & PAGE_SWAPPED) {
+            // On disk: the child points at the same swap slot and reads its own copy back on first touch
+            pt_dst[i] = pt_src[i];
+            dst->page_flags[i] = src->page_flags[i];
+            SwapRefSlot(pt_src[i].pfn);
+            continue;
+        }
+        if (src->page_flags[i] & PAGE_LAZY) {
+            // Not loaded yet, the child will fault it in from its own copy of the backing
+            dst->page_flags[i] |= PAGE_LAZY;
+            dst->page_backing[i] = src->page_backing[i];
+        }
         if (pt_src[i].valid == 1) {
-            // Allocate a frame to mape the destination page table entry to
-            int dst_frame = allocFrame(FRAME_USER, dst->pid);
-            if (dst_frame == -1) {
-                TracePrintf(0, "CopyPT: Failed to allocate a frame for the destination process PID %d pagetable!\n", dst->pid);
-                return ERROR;
+            if (src->page_flags[i] & PAGE_SHARED) {
+                // Shared_Pages memory stays writable and is the same frame in both processes
+                dst->page_flags[i] |= PAGE_SHARED;
+            } else if ((pt_src[i].prot & PROT_WRITE) || (src->page_flags[i] & PAGE_COW)) {
+                pt_src[i].prot &= ~PROT_WRITE;
+                src->page_flags[i] |= PAGE_COW;
+                dst->page_flags[i] |= PAGE_COW;
             }
-
-            int src_frame = pt_src[i].pfn;
-            // Copy the contents of the src frame to the dst frame
-            CloneFrame(src_frame, dst_frame);
+            frameRef(pt_src[i].pfn);
 
             // Filling in the pagetable entry
-            pt_dst[i].pfn = dst_frame;
+            pt_dst[i].pfn = pt_src[i].pfn;
             pt_dst[i].valid = 1;
             pt_dst[i].prot = pt_src[i].prot;
         }
    }
-   TracePrintf(0, "CopyPT: Succesfully copied pagetable from process PID %d to process PID %d!\n", src->pid, dst->pid);
+   // The parent's writable mappings were just downgraded, drop any stale ones from the TLB
+   WriteRegister(REG_TLB_FLUSH, TLB_FLUSH_1);
+   TracePrintf(0, "CopyPT: Succesfully shared pagetable of process PID %d with process PID %d (copy-on-write)!\n", src->pid, dst->pid);
    return SUCCESS;
-}
\ No newline at end of file
+}
+
+int BreakCOW(PCB *proc, int vpn) {
+    pte_t *pte = &proc->ptbr[vpn];
+    if (pte->valid == 0 || !(proc->page_flags[vpn] & PAGE_COW)) {
+        return ERROR;
+    }
+
+    int old_pfn = pte->pfn;
+    if (frame_table[old_pfn].refcount > 1) {
+        // Someone else still maps this frame, give this process its own copy
+        int new_pfn = allocFrameEvict(FRAME_USER, proc->pid);
+        if (new_pfn == -1) {
+            TracePrintf(0, "BreakCOW: Out of frames copying page %d for process PID %d!\n", vpn, proc->pid);
+            return ERROR;
+        }
+        CloneFrame(old_pfn, new_pfn);
+        freeFrame(old_pfn);
+        pte->pfn = new_pfn;
+    } else {
+        frame_table[old_pfn].owner_pid = proc->pid;
+    }
+
+    pte->prot |= PROT_WRITE;
+    proc->page_flags[vpn] &= ~PAGE_COW;
+    WriteRegister(REG_TLB_FLUSH, (vpn << PAGESHIFT) + VMEM_1_BASE);
+    return SUCCESS;
+}
+
+int PrepareUserWrite(PCB *proc, void *addr, int len) {
+    if (len <= 0) {
+        return SUCCESS;
+    }
+    int first_vpn = (DOWN_TO_PAGE(addr) - VMEM_1_BASE) >> PAGESHIFT;
+    int last_vpn = (DOWN_TO_PAGE((unsigned int)addr + len - 1) - VMEM_1_BASE) >> PAGESHIFT;
+    for (int vpn = first_vpn; vpn <= last_vpn; vpn++) {
+        if (vpn < 0 || vpn >= MAX_PT_LEN) {
+            return ERROR;
+        }
+        if ((proc->page_flags[vpn] & PAGE_LAZY) && LoadLazyPage(proc, vpn) == ERROR) {
+            return ERROR;
+        }
+        if ((proc->page_flags[vpn] & PAGE_SWAPPED) && SwapIn(proc, vpn) == ERROR) {
+            return ERROR;
+        }
+        if ((proc->page_flags[vpn] & PAGE_COW) && BreakCOW(proc, vpn) == ERROR) {
+            return ERROR;
+        }
+    }
+    return SUCCESS;
+}
+
+int PrepareUserRead(PCB *proc, void *addr, int len) {
+    if (len <= 0) {
+        return SUCCESS;
+    }
+    int first_vpn = (DOWN_TO_PAGE(addr) - VMEM_1_BASE) >> PAGESHIFT;
+    int last_vpn = (DOWN_TO_PAGE((unsigned int)addr + len - 1) - VMEM_1_BASE) >> PAGESHIFT;
+    for (int vpn = first_vpn; vpn <= last_vpn; vpn++) {
+        if (vpn < 0 || vpn >= MAX_PT_LEN) {
+            return ERROR;
+        }
+        if ((proc->page_flags[vpn] & PAGE_LAZY) && LoadLazyPage(proc, vpn) == ERROR) {
+            return ERROR;
+        }
+        if ((proc->page_flags[vpn] & PAGE_SWAPPED) && SwapIn(proc, vpn) == ERROR) {
+            return ERROR;
+        }
+    }
+    return SUCCESS;
+}
+
+int PrepareUserString(PCB *proc, char *str) {
+    unsigned int addr = (unsigned int)str;
+    while (1) {
+        if (addr < VMEM_1_BASE || addr >= VMEM_1_LIMIT) {
+            return ERROR;
+        }
+        int vpn = (DOWN_TO_PAGE(addr) - VMEM_1_BASE) >> PAGESHIFT;
+        if (PrepareUserRead(proc, (void *)addr, 1) == ERROR || proc->ptbr[vpn].valid == 0) {
+            return ERROR;
+        }
+        // Scan the rest of this page for the terminator before touching the next one
+        unsigned int page_end = DOWN_TO_PAGE(addr) + PAGESIZE;
+        for (; addr < page_end; addr++) {
+            if (*(char *)addr == '\0') {
+                return SUCCESS;
+            }
+        }
+    }
+}
+
+static void unpinPages(PCB *proc, int first_vpn, int last_vpn) {
+    for (int vpn = first_vpn; vpn <= last_vpn; vpn++) {
+        frame_table[proc->ptbr[vpn].pfn].pinned--;
+    }
+}
+
+int PinUserBuffer(PCB *proc, void *addr, int len, int prot) {
+    if (len <= 0) {
+        return SUCCESS;
+    }
+    int first_vpn = (DOWN_TO_PAGE(addr) - VMEM_1_BASE) >> PAGESHIFT;
+    int last_vpn = (DOWN_TO_PAGE((unsigned int)addr + len - 1) - VMEM_1_BASE) >> PAGESHIFT;
+    for (int vpn = first_vpn; vpn <= last_vpn; vpn++) {
+        void *page = (void *)(VMEM_1_BASE + (vpn << PAGESHIFT));
+        int status = (prot & PROT_WRITE) ? PrepareUserWrite(proc, page, 1) : PrepareUserRead(proc, page, 1);
+        if (status == ERROR || proc->ptbr[vpn].valid == 0 ||
+            ((prot & PROT_WRITE) && !(proc->ptbr[vpn].prot & PROT_WRITE))) {
+            unpinPages(proc, first_vpn, vpn - 1);
+            return ERROR;
+        }
+        frame_table[proc->ptbr[vpn].pfn].pinned++;
+    }
+    return SUCCESS;
+}
+
+void UnpinUserBuffer(PCB *proc, void *addr, int len) {
+    if (len <= 0) {
+        return;
+    }
+    int first_vpn = (DOWN_TO_PAGE(addr) - VMEM_1_BASE) >> PAGESHIFT;
+    int last_vpn = (DOWN_TO_PAGE((unsigned int)addr + len - 1) - VMEM_1_BASE) >> PAGESHIFT;
+    unpinPages(proc, first_vpn, last_vpn);
+}
@@ -4,20 +4,35 @@
 #include "hardware.h"
 #include "queue.h"
 #include "mem.h"
+#include "image.h"
+#include "slab.h"
+#include "syscalls/tty.h"
+#include "sched.h"
+#include <unistd.h>
 
 
 PCB *idle_proc; // Pointer to the idle process PCB
 PCB *init_proc;
 PCB *current_process; // Pointer to the current running process PCB
-queue_t *ready_queue; // A FIFO queue of processes ready to be executed by the cpu
-queue_t *blocked_queue; // A queue of processes blocked (either waiting on a lock, cvar or waiting for an I/O to finish)
-queue_t *zombie_queue; // A queue of processes that have terminated but whose parent has not yet called Wait()
-queue_t *waiting_parents; // A queue of processes blocked waiting for a child to exit;
+queue_t *reap_queue; // Exited processes whose kernel stacks still have to be freed
 
 PCB **proc_table;
 
+// Free proc_table slots, kept as a stack so Fork never scans the table
+static int free_proc_slots[MAX_PROCS];
+static int nfree_proc_slots;
+
+// pid -> PCB hash, chained through PCB.pid_hash_next
+#define PID_HASH_SIZE 128 /* power of two */
+static PCB *pid_hash[PID_HASH_SIZE];
+static void pidHashRemove(PCB *process);
+
+// PCBs and region 1 page tables are fixed-size and churn on every Fork/Exit
+static slab_cache_t pcb_cache = SLAB_CACHE_INIT("pcb", sizeof(PCB));
+static slab_cache_t page_table_cache = SLAB_CACHE_INIT("page table", NUM_PAGES_REGION1 * sizeof(pte_t));
+
 PCB *allocNewPCB() {
-    PCB *process = (PCB *)malloc(sizeof(PCB));
+    PCB *process = (PCB *)slabAlloc(&pcb_cache);
     if (process == NULL) {
         TracePrintf(0, "allocNewPCB: Failed to allocate memory for PCB.\n");
         return NULL;
@@ -29,15 +44,16 @@ PCB *allocNewPCB() {
     process->ppid = INVALID_PID;      // no parent yet
     process->state = PROC_FREE;
     process->exit_status = 0;
-    process->ptbr = (pte_t *)malloc(NUM_PAGES_REGION1 * sizeof(pte_t));
+    process->ptbr = (pte_t *)slabAlloc(&page_table_cache);
 
     if (process->ptbr == NULL) {
         TracePrintf(0, "create_PCB: Failed to allocate memory for region page table.\n");
-        free(process);
+        slabFree(&pcb_cache, process);
         return NULL;
     }
     memset(process->ptbr, 0, NUM_PAGES_REGION1 * sizeof(pte_t)); // All entries are invalid
     process->ptlr = NUM_PAGES_REGION1;
+    process->exec_fd = -1;
     
 
     
@@ -53,18 +69,29 @@ PCB *allocNewPCB() {
     // Queue links and relationships
     process->next = NULL;
     process->prev = NULL;
+    process->on_list = NULL;
     process->parent = NULL;
     process->children_processes = queueCreate();
     if (process->children_processes == NULL) {
         TracePrintf(0, "allocNewPCB: Failed to create children queue.\n");
-        free(process->ptbr);
-        free(process);
+        slabFree(&page_table_cache, process->ptbr);
+        slabFree(&pcb_cache, process);
         return NULL;
     }
     // Bookkeeping
-    process->waiting_for_child_pid = INVALID_PID;
+    procListInit(&process->zombie_children);
+    WaitQueueInit(&process->child_exit, "child exit");
     process->last_run_tick = 0;
-    process->delay_ticks = 0;
+    process->wake_tick = 0;
+    process->priority = 0;
+    process->quantum = default_quantum;
+    process->tickets = SCHED_DEFAULT_TICKETS;
+    process->stride = SCHED_STRIDE1 / SCHED_DEFAULT_TICKETS;
+    process->pass = 0;
+    process->cpu_ticks = 0;
+    process->switches_out = 0;
+    memset(process->syscall_stats, 0, sizeof(process->syscall_stats));
+    process->ticks_left = 0; // the scheduler starts a slice when the process first becomes ready
 
     TracePrintf(1, "allocNewPCB: New PCB created at %p\n", process);
     return process;
@@ -87,81 +114,124 @@ void deletePCB(PCB *process) {
     // Free up the queue created for children processes
     queueDelete(process->children_processes);
 
-    // Free memory allocated for region 1 (make sure we freed the frames used up)
-    free(process->ptbr);
-    // Free memory allocated for kstack (make sure we freed the frames used up)
-    free(process->kstack);
+    // Whatever Exit didn't already give back (the pid 1 path and failed Forks come here directly)
+    FreeRegion1(process);
+    TtyReleaseProcess(process);
+    ReleaseKernelStack(process);
+    if (process->reap_pending) {
+        queueRemove(reap_queue, process);
+        process->reap_pending = 0;
+    }
+
+    // Free memory allocated for region 1
+    slabFree(&page_table_cache, process->ptbr);
+
+    if (proc_table[process->slot] == process) {
+        proc_table[process->slot] = NULL;
+        free_proc_slots[nfree_proc_slots++] = process->slot;
+    }
+    pidHashRemove(process);
+    helper_retire_pid(process->pid);
 
     // finally free up the pcb struct allocated for this process
-    free(process);
+    slabFree(&pcb_cache, process);
 }
 
-PCB *getFreePCB(void) {
-    if (proc_table == NULL) {
-        TracePrintf(0, "getFreePCB: The process table is not initialized.\n");
-        return NULL;
+void ReleaseKernelStack(PCB *process) {
+    if (process->kstack == NULL) {
+        return;
     }
-    
-    // Look for an empty (NULL) slot
-    for (int i = 0; i < MAX_PROCS; i++) {
-        if (proc_table[i] == NULL) {
-            
-            // Found one! Allocate a new PCB for it.
-            PCB *pcb = allocNewPCB();
-            
-            // Put it in the table
-            proc_table[i] = pcb; 
-            
-            // Set its initial state and return it
-            pcb->state = PROC_RUNNING; // Or whatever state you use for "new"
-            pcb->pid = helper_new_pid(pcb->ptbr);
-            
-            return pcb;
+    for (int i = 0; i < KSTACK_PAGES; i++) {
+        if (process->kstack[i].valid) {
+            freeFrame(process->kstack[i].pfn);
         }
     }
-    
-    // No NULL slots found, table is full
-    return NULL;
+    free(process->kstack);
+    process->kstack = NULL;
 }
 
-void CloneRegion1(PCB *pcb_from, PCB *pcb_to) {
-    pte_t *pt_region1_from = pcb_from->ptbr;
-    pte_t *pt_region1_to = pcb_to->ptbr;
-    for (int i = 0; i < NUM_PAGES_REGION1; i++) {
-        if (pt_region1_from[i].valid == 1) {
-            int pfn_to = allocFrame(FRAME_USER, pcb_to->pid);
-            int pfn_from = pt_region1_from[i].pfn;
-            CloneFrame(pfn_from, pfn_to);
-
-            pt_region1_to[i].pfn = pfn_to;
-            pt_region1_to[i].prot = pt_region1_from[i].prot;
-            pt_region1_to[i].valid = 1;
+void ReapExitedProcesses(void) {
+    QueueNode_t *node = reap_queue->head;
+    while (node != NULL) {
+        QueueNode_t *next_node = node->next;
+        PCB *process = node->process;
+        // The process that just exited may still be on its way out on its own stack
+        if (process != current_process) {
+            queueRemove(reap_queue, process);
+            process->reap_pending = 0;
+            ReleaseKernelStack(process);
+            if (process->parent == NULL) {
+                // Orphans have nobody to Wait for them
+                TracePrintf(1, "ReapExitedProcesses: Deleting orphaned process PID %d\n", process->pid);
+                deletePCB(process);
+            }
         }
+        node = next_node;
     }
 }
 
-void InitializeProcQueues(void) {
-    ready_queue = queueCreate();
-    if (ready_queue == NULL) {
-        TracePrintf(0, "ready_queue: Couldn't allocate memory for ready queue.\n");
-        Halt();
+void InitializePidIndex(void) {
+    nfree_proc_slots = 0;
+    for (int slot = MAX_PROCS - 1; slot >= 0; slot--) {
+        free_proc_slots[nfree_proc_slots++] = slot;
     }
+    memset(pid_hash, 0, sizeof(pid_hash));
+}
 
-    blocked_queue = queueCreate();
-    if (blocked_queue == NULL) {
-        TracePrintf(0, "blocked_queue: Couldn't allocate memory for blocked queue.\n");
-        Halt();
+PCB *findPCB(int pid) {
+    PCB *process = pid_hash[pid & (PID_HASH_SIZE - 1)];
+    while (process != NULL && process->pid != pid) {
+        process = process->pid_hash_next;
+    }
+    return process;
+}
+
+static void pidHashRemove(PCB *process) {
+    PCB **link = &pid_hash[process->pid & (PID_HASH_SIZE - 1)];
+    while (*link != NULL && *link != process) {
+        link = &(*link)->pid_hash_next;
     }
+    if (*link == process) {
+        *link = process->pid_hash_next;
+    }
+    process->pid_hash_next = NULL;
+}
 
-    zombie_queue = queueCreate();
-    if (zombie_queue == NULL) {
-        TracePrintf(0, "zombie_queue: Couldn't allocate memory for zombie queue.\n");
-        Halt();
+PCB *getFreePCB(void) {
+    if (proc_table == NULL) {
+        TracePrintf(0, "getFreePCB: The process table is not initialized.\n");
+        return NULL;
     }
+    if (nfree_proc_slots == 0) {
+        // No free slots, table is full
+        return NULL;
+    }
+
+    PCB *pcb = allocNewPCB();
+    if (pcb == NULL) {
+        return NULL;
+    }
+
+    // Put it in the table
+    int slot = free_proc_slots[--nfree_proc_slots];
+    proc_table[slot] = pcb;
+    pcb->slot = slot;
+
+    // Set its initial state and return it
+    pcb->state = PROC_RUNNING; // Or whatever state you use for "new"
+    pcb->pid = helper_new_pid(pcb->ptbr);
+
+    int bucket = pcb->pid & (PID_HASH_SIZE - 1);
+    pcb->pid_hash_next = pid_hash[bucket];
+    pid_hash[bucket] = pcb;
+    return pcb;
+}
+
+void InitializeProcQueues(void) {
 
-    waiting_parents = queueCreate();
-    if (waiting_parents == NULL) {
-        TracePrintf(0, "waiting_parents: Couldn't allocate memory for waiting parents queue.\n");
+    reap_queue = queueCreate();
+    if (reap_queue == NULL) {
+        TracePrintf(0, "reap_queue: Couldn't allocate memory for reap queue.\n");
         Halt();
     }
 }
@@ -188,6 +258,8 @@ PCB *CreateIdlePCB(UserContext *uctxt) {
     return idle_proc;
 }
 
+// Runs in user mode, so it cannot touch frames itself; the clock trap refills the zeroed
+// frame pool whenever it interrupts this loop.
 void DoIdle(void) {
     while (1) {
         TracePrintf(0, "Running Idle Process...\n");
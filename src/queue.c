@@ -1,9 +1,14 @@
 #include "queue.h"
 #include "ykernel.h"
 #include "proc.h"
+#include "slab.h"
+
+// Queues and their nodes are created and freed on every block/wake, so they come from object caches
+static slab_cache_t queue_cache = SLAB_CACHE_INIT("queue", sizeof(queue_t));
+static slab_cache_t queue_node_cache = SLAB_CACHE_INIT("queue node", sizeof(QueueNode_t));
 
 QueueNode_t *newNode() {
-    QueueNode_t *node = malloc(sizeof(QueueNode_t));
+    QueueNode_t *node = slabAlloc(&queue_node_cache);
     if (node == NULL) {
         return NULL;
     }
@@ -15,7 +20,7 @@ QueueNode_t *newNode() {
 }
 
 queue_t *queueCreate() {
-    queue_t *queue = malloc(sizeof(queue_t));
+    queue_t *queue = slabAlloc(&queue_cache);
     if (queue) {
         queue->head = NULL;
         queue->tail = NULL;
@@ -41,7 +46,7 @@ void queueRemove(queue_t *queue, PCB *process) {
             if (node->next == NULL) queue->tail = node->prev;
             else node->next->prev = node->prev;
             TracePrintf(0, "queueRemove: Removed process PID %d from queue!\n", process->pid);
-            free(node);
+            slabFree(&queue_node_cache, node);
             return;
         }
         node = node->next;
@@ -97,7 +102,7 @@ PCB *queueDequeue(queue_t *queue) {
         queue->head->prev = NULL;
     }
 
-    free(node);
+    slabFree(&queue_node_cache, node);
     TracePrintf(1, "queueDequeue: Dequeued process (%d pid)\n", p->pid);
     return p;
 }
@@ -123,10 +128,10 @@ void queueDelete(queue_t *queue) {
     QueueNode_t *curr = queue->head;
     while (curr != NULL) {
         QueueNode_t *next = curr->next;
-        free(curr);
+        slabFree(&queue_node_cache, curr);
         curr = next;
     }
-    free(queue);
+    slabFree(&queue_cache, queue);
 }
 
 int is_in_queue(queue_t * queue, PCB *process) {
@@ -176,3 +181,53 @@ void print_queue(queue_t *queue) {
     }
     TracePrintf(0, "--- End of Queue (addr %p) ---\n", queue);
 }
+
+void procListInit(proc_list_t *list) {
+    list->head = NULL;
+    list->tail = NULL;
+    list->count = 0;
+}
+
+void procListEnqueue(proc_list_t *list, PCB *process) {
+    if (process->on_list != NULL) {
+        TracePrintf(0, "procListEnqueue: Process PID %d is already on a list!\n", process->pid);
+        Halt();
+    }
+    process->next = NULL;
+    process->prev = list->tail;
+    if (list->tail == NULL) {
+        list->head = process;
+    } else {
+        list->tail->next = process;
+    }
+    list->tail = process;
+    list->count++;
+    process->on_list = list;
+}
+
+PCB *procListDequeue(proc_list_t *list) {
+    PCB *process = list->head;
+    if (process != NULL) {
+        procListRemove(process);
+    }
+    return process;
+}
+
+void procListRemove(PCB *process) {
+    proc_list_t *list = process->on_list;
+    if (list == NULL) {
+        return;
+    }
+    if (process->prev == NULL) list->head = process->next;
+    else process->prev->next = process->next;
+    if (process->next == NULL) list->tail = process->prev;
+    else process->next->prev = process->prev;
+    list->count--;
+    process->next = NULL;
+    process->prev = NULL;
+    process->on_list = NULL;
+}
+
+int procListIsEmpty(proc_list_t *list) {
+    return (list->head == NULL);
+}
@@ -0,0 +1,110 @@
+#include "sched.h"
+#include "kernel.h"
+#include <ykernel.h>
+
+// Every policy the "sched=" option can pick
+static sched_ops_t *sched_policies[] = { &sched_mlfq_ops, &sched_rr_ops, &sched_stride_ops };
+#define SCHED_NPOLICIES (sizeof(sched_policies) / sizeof(sched_policies[0]))
+
+sched_ops_t *sched_ops = &sched_mlfq_ops;
+
+int default_quantum = 1;
+
+int SchedSelectPolicy(char *name) {
+    for (unsigned int i = 0; i < SCHED_NPOLICIES; i++) {
+        if (strcmp(sched_policies[i]->name, name) == 0) {
+            sched_ops = sched_policies[i];
+            return SUCCESS;
+        }
+    }
+    return ERROR;
+}
+
+void InitializeScheduler(void) {
+    TracePrintf(1, "InitializeScheduler: Using the %s policy\n", sched_ops->name);
+    sched_ops->init();
+}
+
+void SchedRefillSlice(PCB *proc) {
+    proc->ticks_left = proc->quantum << proc->priority;
+}
+
+void SchedReady(PCB *proc) {
+    if (proc->ticks_left <= 0) {
+        SchedRefillSlice(proc);
+    }
+    proc->state = PROC_READY;
+    sched_ops->enqueue(proc);
+}
+
+void SchedWake(PCB *proc) {
+    if (sched_ops->on_wake != NULL) {
+        sched_ops->on_wake(proc);
+    }
+    SchedReady(proc);
+}
+
+PCB *SchedPickNext(void) {
+    PCB *next = sched_ops->pick_next();
+    return (next != NULL) ? next : idle_proc;
+}
+
+int SchedHasReady(void) {
+    return sched_ops->has_ready();
+}
+
+void SchedBlockedOnIO(PCB *proc) {
+    if (sched_ops->on_block != NULL) {
+        sched_ops->on_block(proc);
+    }
+    SchedRefillSlice(proc);
+}
+
+int SchedCanHandoff(PCB *curr, PCB *to) {
+    if (sched_ops->can_handoff == NULL) {
+        return 1;
+    }
+    return sched_ops->can_handoff(curr, to);
+}
+
+void SchedHandoff(PCB *curr, PCB *to) {
+    sched_ops->dequeue(to);
+    if (curr == idle_proc) {
+        return;
+    }
+    if (curr->state == PROC_RUNNING) {
+        SchedReady(curr);
+    } else if (curr->ticks_left > to->ticks_left) {
+        // curr won't use the rest of its slice, so the process it woke gets it
+        to->ticks_left = curr->ticks_left;
+        curr->ticks_left = 0;
+    }
+}
+
+int SchedTick(PCB *curr) {
+    if (curr != idle_proc) {
+        curr->cpu_ticks++;
+    }
+    return sched_ops->on_tick(curr);
+}
+
+int SchedSetQuantum(PCB *proc, int ticks) {
+    if (ticks < 0 || ticks > SCHED_MAX_QUANTUM) {
+        return ERROR;
+    }
+    int old_quantum = proc->quantum;
+    proc->quantum = (ticks == 0) ? default_quantum : ticks;
+    TracePrintf(1, "SchedSetQuantum: Process PID %d quantum %d -> %d\n", proc->pid, old_quantum, proc->quantum);
+    return old_quantum;
+}
+
+int SchedSetShare(PCB *proc, int tickets) {
+    if (tickets < 0 || tickets > SCHED_MAX_TICKETS) {
+        return ERROR;
+    }
+    int old_tickets = proc->tickets;
+    proc->tickets = (tickets == 0) ? SCHED_DEFAULT_TICKETS : tickets;
+    proc->stride = SCHED_STRIDE1 / proc->tickets;
+    TracePrintf(1, "SchedSetShare: Process PID %d tickets %d -> %d\n", proc->pid, old_tickets, proc->tickets);
+    return old_tickets;
+}
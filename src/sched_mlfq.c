@@ -0,0 +1,99 @@
+#include "sched.h"
+#include "kernel.h"
+#include <ykernel.h>
+
+// Multi-level feedback queue, see sched.h
+static proc_list_t ready_queues[SCHED_LEVELS]; // ready processes, one FIFO per priority level
+static int ticks_since_boost = 0;
+
+static void MLFQInit(void) {
+    for (int level = 0; level < SCHED_LEVELS; level++) {
+        procListInit(&ready_queues[level]);
+    }
+}
+
+static void MLFQEnqueue(PCB *proc) {
+    procListEnqueue(&ready_queues[proc->priority], proc);
+}
+
+static void MLFQDequeue(PCB *proc) {
+    procListRemove(proc);
+}
+
+static PCB *MLFQPickNext(void) {
+    for (int level = 0; level < SCHED_LEVELS; level++) {
+        if (!procListIsEmpty(&ready_queues[level])) {
+            return procListDequeue(&ready_queues[level]);
+        }
+    }
+    return NULL;
+}
+
+static int MLFQHasReady(void) {
+    for (int level = 0; level < SCHED_LEVELS; level++) {
+        if (!procListIsEmpty(&ready_queues[level])) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+// Moves every process back to level 0, keeping the ready processes in their current order
+static void MLFQBoostAll(void) {
+    for (int i = 0; i < MAX_PROCS; i++) {
+        if (proc_table[i] != NULL) {
+            proc_table[i]->priority = 0;
+            SchedRefillSlice(proc_table[i]);
+        }
+    }
+    for (int level = 1; level < SCHED_LEVELS; level++) {
+        while (!procListIsEmpty(&ready_queues[level])) {
+            procListEnqueue(&ready_queues[0], procListDequeue(&ready_queues[level]));
+        }
+    }
+    TracePrintf(1, "MLFQBoostAll: Reset every process to priority 0\n");
+}
+
+static int MLFQOnTick(PCB *curr) {
+    if (++ticks_since_boost >= SCHED_BOOST_PERIOD) {
+        ticks_since_boost = 0;
+        MLFQBoostAll();
+    }
+    if (curr == idle_proc) {
+        return 1;
+    }
+
+    if (--curr->ticks_left <= 0) {
+        if (curr->priority < SCHED_LEVELS - 1) {
+            curr->priority++;
+        }
+        SchedRefillSlice(curr);
+        return 1;
+    }
+    // A process that came back from I/O at a better level doesn't wait out our quantum
+    for (int level = 0; level < curr->priority; level++) {
+        if (!procListIsEmpty(&ready_queues[level])) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+static void MLFQOnBlock(PCB *proc) {
+    if (proc->priority > 0) {
+        proc->priority--;
+    }
+}
+
+sched_ops_t sched_mlfq_ops = {
+    .name = "mlfq",
+    .init = MLFQInit,
+    .enqueue = MLFQEnqueue,
+    .dequeue = MLFQDequeue,
+    .pick_next = MLFQPickNext,
+    .has_ready = MLFQHasReady,
+    .on_tick = MLFQOnTick,
+    .on_block = MLFQOnBlock,
+    .on_wake = NULL,
+    .can_handoff = NULL,
+};
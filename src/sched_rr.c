@@ -0,0 +1,50 @@
+#include "sched.h"
+#include "kernel.h"
+#include <ykernel.h>
+
+// Round robin: a single FIFO, every process runs its base quantum in turn
+static proc_list_t rr_queue;
+
+static void RRInit(void) {
+    procListInit(&rr_queue);
+}
+
+static void RREnqueue(PCB *proc) {
+    procListEnqueue(&rr_queue, proc);
+}
+
+static void RRDequeue(PCB *proc) {
+    procListRemove(proc);
+}
+
+static PCB *RRPickNext(void) {
+    return procListDequeue(&rr_queue);
+}
+
+static int RRHasReady(void) {
+    return !procListIsEmpty(&rr_queue);
+}
+
+static int RROnTick(PCB *curr) {
+    if (curr == idle_proc) {
+        return 1;
+    }
+    if (--curr->ticks_left <= 0) {
+        SchedRefillSlice(curr);
+        return 1;
+    }
+    return 0;
+}
+
+sched_ops_t sched_rr_ops = {
+    .name = "rr",
+    .init = RRInit,
+    .enqueue = RREnqueue,
+    .dequeue = RRDequeue,
+    .pick_next = RRPickNext,
+    .has_ready = RRHasReady,
+    .on_tick = RROnTick,
+    .on_block = NULL,
+    .on_wake = NULL,
+    .can_handoff = NULL,
+};
@@ -0,0 +1,90 @@
+#include "sched.h"
+#include "kernel.h"
+#include <ykernel.h>
+
+// Stride scheduling, see sched.h. Ready processes sit on one unordered list; picking scans
+// it for the lowest pass, which is cheap next to MAX_PROCS and keeps enqueue O(1)
+static proc_list_t stride_queue;
+static unsigned int stride_vtime = 0; // pass of the process picked last
+
+// Pass values wrap around, so compare them by their difference
+static int passBefore(unsigned int a, unsigned int b) {
+    return (int)(a - b) < 0;
+}
+
+static void StrideInit(void) {
+    procListInit(&stride_queue);
+}
+
+static void StrideEnqueue(PCB *proc) {
+    procListEnqueue(&stride_queue, proc);
+}
+
+// Only used for a handoff, so proc is about to run: it sets the virtual time just as a pick would
+static void StrideDequeue(PCB *proc) {
+    procListRemove(proc);
+    stride_vtime = proc->pass;
+}
+
+static PCB *StridePickNext(void) {
+    PCB *best = stride_queue.head;
+    for (PCB *proc = stride_queue.head; proc != NULL; proc = proc->next) {
+        if (passBefore(proc->pass, best->pass)) {
+            best = proc;
+        }
+    }
+    if (best != NULL) {
+        procListRemove(best);
+        stride_vtime = best->pass;
+    }
+    return best;
+}
+
+static int StrideHasReady(void) {
+    return !procListIsEmpty(&stride_queue);
+}
+
+static int StrideOnTick(PCB *curr) {
+    if (curr == idle_proc) {
+        return 1;
+    }
+    curr->pass += curr->stride;
+    if (--curr->ticks_left <= 0) {
+        SchedRefillSlice(curr);
+        return 1;
+    }
+    return 0;
+}
+
+static void StrideOnWake(PCB *proc) {
+    // No credit for time spent asleep
+    if (passBefore(proc->pass, stride_vtime)) {
+        proc->pass = stride_vtime;
+    }
+}
+
+// A handoff skips StridePickNext, so only allow it when the wakee is the one it would pick anyway
+static int StrideCanHandoff(PCB *curr, PCB *to) {
+    if (curr != idle_proc && curr->state == PROC_RUNNING && passBefore(curr->pass, to->pass)) {
+        return 0;
+    }
+    for (PCB *proc = stride_queue.head; proc != NULL; proc = proc->next) {
+        if (proc != to && passBefore(proc->pass, to->pass)) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+sched_ops_t sched_stride_ops = {
+    .name = "stride",
+    .init = StrideInit,
+    .enqueue = StrideEnqueue,
+    .dequeue = StrideDequeue,
+    .pick_next = StridePickNext,
+    .has_ready = StrideHasReady,
+    .on_tick = StrideOnTick,
+    .on_block = NULL,
+    .on_wake = StrideOnWake,
+    .can_handoff = StrideCanHandoff,
+};
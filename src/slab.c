@@ -0,0 +1,63 @@
+#include "slab.h"
+#include "kernel.h"
+#include "mem.h"
+
+int slab_low_page = SCRATCH_WINDOW_BASE >> PAGESHIFT;
+
+// Maps one more page at the bottom of the slab area
+static void *slabGrowPage(void) {
+    int vpn = slab_low_page - 1;
+    if (vpn < kernel_brk_page) {
+        TracePrintf(0, "slabGrowPage: slab area ran into the kernel heap\n");
+        return NULL;
+    }
+
+    // Before VM is on, addresses are physical, so the page has to be backed by the frame of the same number
+    int pfn = is_vm_enabled ? allocFrame(FRAME_KERNEL, -1) : allocSpecificFrame(vpn, FRAME_KERNEL, -1);
+    if (pfn == -1) {
+        TracePrintf(0, "slabGrowPage: out of physical frames\n");
+        return NULL;
+    }
+    MapRegion0(vpn, pfn);
+    if (is_vm_enabled) {
+        WriteRegister(REG_TLB_FLUSH, vpn << PAGESHIFT);
+    }
+    slab_low_page = vpn;
+    return (void *)(vpn << PAGESHIFT);
+}
+
+void *slabAlloc(slab_cache_t *cache) {
+    if (cache->free_list == NULL) {
+        // Caches not built with SLAB_CACHE_INIT get their size checked here, before a page is wasted on them
+        if (cache->obj_size < (int)sizeof(void *) || cache->obj_size > PAGESIZE) {
+            TracePrintf(0, "slabAlloc: cache '%s' has a bad object size %d\n", cache->name, cache->obj_size);
+            return NULL;
+        }
+        char *page = slabGrowPage();
+        if (page == NULL) {
+            return NULL;
+        }
+        // Carve the page into objects and thread them onto the free list
+        for (int off = 0; off + cache->obj_size <= PAGESIZE; off += cache->obj_size) {
+            *(void **)(page + off) = cache->free_list;
+            cache->free_list = page + off;
+            cache->nfree++;
+        }
+        cache->npages++;
+        TracePrintf(1, "slabAlloc: cache '%s' grew to %d pages\n", cache->name, cache->npages);
+    }
+
+    void *obj = cache->free_list;
+    cache->free_list = *(void **)obj;
+    cache->nfree--;
+    return obj;
+}
+
+void slabFree(slab_cache_t *cache, void *obj) {
+    if (obj == NULL) {
+        return;
+    }
+    *(void **)obj = cache->free_list;
+    cache->free_list = obj;
+    cache->nfree++;
+}
@@ -0,0 +1,190 @@
+#include "swap.h"
+#include "mem.h"
+#include "waitqueue.h"
+#include "traps/trap.h"
+#include "sched.h"
+
+int swap_enabled = 0;
+
+static unsigned char *slot_refs;  // mappings referencing each slot, 0 = free
+static int *free_slots;           // stack of free slot numbers
+static int nfree_slots;
+static char *swap_buf;            // region 0 bounce buffer for one page
+
+// The disk does one transfer at a time; whoever holds it owns swap_buf too
+static int disk_busy;
+static wait_queue_t disk_io;      // the disk owner, waiting for the transfer in flight
+static wait_queue_t disk_waiters; // processes waiting to use the disk
+
+// Clock hand over (process table slot, region 1 vpn)
+static int clock_proc;
+static int clock_vpn;
+
+void InitializeSwap(void) {
+    slot_refs = malloc(SWAP_NSLOTS);
+    free_slots = malloc(sizeof(int) * SWAP_NSLOTS);
+    swap_buf = malloc(PAGESIZE);
+    if (slot_refs == NULL || free_slots == NULL || swap_buf == NULL) {
+        TracePrintf(0, "InitializeSwap: Couldn't allocate swap bookkeeping. Swapping disabled.\n");
+        swap_enabled = 0;
+        return;
+    }
+    memset(slot_refs, 0, SWAP_NSLOTS);
+    nfree_slots = 0;
+    for (int slot = SWAP_NSLOTS - 1; slot >= 0; slot--) {
+        free_slots[nfree_slots++] = slot;
+    }
+    disk_busy = 0;
+    WaitQueueInit(&disk_io, "disk io");
+    WaitQueueInit(&disk_waiters, "disk waiters");
+    clock_proc = 0;
+    clock_vpn = 0;
+    TracePrintf(1, "InitializeSwap: %d swap slots of %d sectors each.\n", SWAP_NSLOTS, SECTORS_PER_PAGE);
+}
+
+// Disk waits count as I/O for the scheduler
+static void SwapSleep(wait_queue_t *wq) {
+    SchedBlockedOnIO(current_process);
+    WaitQueueSleep(wq);
+}
+
+static void DiskLock(void) {
+    while (disk_busy) {
+        SwapSleep(&disk_waiters);
+    }
+    disk_busy = 1;
+}
+
+static void DiskUnlock(void) {
+    disk_busy = 0;
+    WaitQueueWakeOne(&disk_waiters);
+}
+
+// Moves swap_buf to/from a slot one sector at a time, sleeping until each TRAP_DISK
+static void DiskTransferPage(int op, int slot) {
+    for (int s = 0; s < SECTORS_PER_PAGE; s++) {
+        DiskAccess(op, SWAP_FIRST_SECTOR + slot * SECTORS_PER_PAGE + s, swap_buf + s * SECTORSIZE);
+        SwapSleep(&disk_io);
+    }
+}
+
+void SwapDiskInterrupt(void) {
+    WaitQueueWakeOne(&disk_io);
+}
+
+void SwapRefSlot(int slot) {
+    slot_refs[slot]++;
+}
+
+void SwapFreeSlot(int slot) {
+    if (slot < 0 || slot >= SWAP_NSLOTS || slot_refs[slot] == 0) {
+        TracePrintf(0, "SwapFreeSlot: slot %d is not in use\n", slot);
+        return;
+    }
+    if (--slot_refs[slot] == 0) {
+        free_slots[nfree_slots++] = slot;
+    }
+}
+
+static int SwapPickVictim(PCB **victim, int *victim_vpn) {
+    // Two full sweeps: the first one may only clear reference bits
+    for (int steps = 0; steps < 2 * MAX_PROCS * MAX_PT_LEN; steps++) {
+        PCB *process = proc_table[clock_proc];
+        int vpn = clock_vpn;
+        if (++clock_vpn >= MAX_PT_LEN) {
+            clock_vpn = 0;
+            clock_proc = (clock_proc + 1) % MAX_PROCS;
+        }
+
+        if (process == NULL || process == current_process || process == idle_proc ||
+            process->swap_busy > 0 || process->state == PROC_ZOMBIE || process->state == PROC_FREE) {
+            continue;
+        }
+        pte_t *pte = &process->ptbr[vpn];
+        if (pte->valid == 0 || (process->page_flags[vpn] & PAGE_SHARED)) {
+            continue; // Shared_Pages frames must stay one frame for everyone mapping them
+        }
+        frame_desc_t *frame = &frame_table[pte->pfn];
+        if (frame->usage != FRAME_USER || frame->refcount != 1 || frame->pinned > 0) {
+            continue; // shared frames (COW, cached text) stay put, and so do frames the kernel is copying
+        }
+        if (frame->referenced) {
+            frame->referenced = 0; // second chance
+            continue;
+        }
+        *victim = process;
+        *victim_vpn = vpn;
+        return SUCCESS;
+    }
+    return ERROR;
+}
+
+int SwapEvictOne(void) {
+    PCB *curr = current_process;
+    if (!swap_enabled || curr == NULL || curr == idle_proc) {
+        return ERROR;
+    }
+
+    curr->swap_busy++;
+    DiskLock();
+
+    PCB *victim;
+    int vpn;
+    if (nfree_slots == 0 || SwapPickVictim(&victim, &vpn) == ERROR) {
+        TracePrintf(0, "SwapEvictOne: No page can be swapped out (%d free slots).\n", nfree_slots);
+        DiskUnlock();
+        curr->swap_busy--;
+        return ERROR;
+    }
+
+    int slot = free_slots[--nfree_slots];
+    slot_refs[slot] = 1;
+    pte_t *pte = &victim->ptbr[vpn];
+    int pfn = pte->pfn;
+
+    // Snapshot the page, then unmap it right away so the frame can be reused while the write runs.
+    // The victim isn't running, and its TLB entries go away when it is switched back in.
+    ReadFrame(pfn, swap_buf);
+    pte->valid = 0;
+    pte->pfn = slot;
+    victim->page_flags[vpn] |= PAGE_SWAPPED;
+    freeFrame(pfn);
+
+    TracePrintf(1, "SwapEvictOne: Swapping out page %d of process PID %d (pfn %d) to slot %d.\n", vpn, victim->pid, pfn, slot);
+    DiskTransferPage(DISK_WRITE, slot);
+
+    DiskUnlock();
+    curr->swap_busy--;
+    return SUCCESS;
+}
+
+int SwapIn(PCB *proc, int vpn) {
+    if (!(proc->page_flags[vpn] & PAGE_SWAPPED)) {
+        return ERROR;
+    }
+
+    proc->swap_busy++;
+    int pfn = allocFrameEvict(FRAME_USER, proc->pid);
+    if (pfn == -1) {
+        TracePrintf(0, "SwapIn: Out of frames swapping in page %d of process PID %d!\n", vpn, proc->pid);
+        proc->swap_busy--;
+        return ERROR;
+    }
+
+    DiskLock();
+    int slot = proc->ptbr[vpn].pfn;
+    DiskTransferPage(DISK_READ, slot);
+    WriteFrame(pfn, swap_buf);
+    DiskUnlock();
+    SwapFreeSlot(slot);
+
+    // The invalid pte kept the page's protection, only the frame and valid bit change
+    proc->ptbr[vpn].pfn = pfn;
+    proc->ptbr[vpn].valid = 1;
+    proc->page_flags[vpn] &= ~PAGE_SWAPPED;
+    WriteRegister(REG_TLB_FLUSH, (vpn << PAGESHIFT) + VMEM_1_BASE);
+    proc->swap_busy--;
+
+    TracePrintf(1, "SwapIn: Swapped in page %d of process PID %d from slot %d into pfn %d.\n", vpn, proc->pid, slot, pfn);
+    return SUCCESS;
+}
@@ -1,6 +1,56 @@
 // In manual, reads as an optional syscall for the ledyard bridge problem
+#include "proc.h"
+#include "kernel.h"
+#include "mem.h"
+#include "syscalls/process.h"
+#include "syscalls/shared_pages.h"
+#include <hardware.h>
+#include <ykernel.h>
 
 // Simplified version of mmap.
 // Maps memory of size n to READ/WRITE in userspace
-// Return a ptr to the top of the region or 0 if failed
-int Shared_Pages(int n) {}
+// Return a ptr to the lowest page of the region or 0 if failed
+int Shared_Pages(int n) {
+    PCB *curr = current_process;
+    int heap_vpn = (UP_TO_PAGE(curr->user_heap_end_vaddr) - VMEM_1_BASE) >> PAGESHIFT;
+    int stack_vpn = (DOWN_TO_PAGE(curr->user_stack_base_vaddr) - VMEM_1_BASE) >> PAGESHIFT;
+    if (n <= 0 || n > stack_vpn - SHARED_STACK_RESERVE - heap_vpn) {
+        TracePrintf(SYSCALLS_TRACE_LEVEL, "Shared_Pages: Can't fit %d pages for process PID %d\n", n, curr->pid);
+        return 0;
+    }
+
+    // Take the highest free run of n pages below the stack reserve, so the heap keeps as much room as possible
+    int first_vpn = -1;
+    int run = 0;
+    for (int vpn = stack_vpn - SHARED_STACK_RESERVE - 1; vpn >= heap_vpn; vpn--) {
+        int in_use = curr->ptbr[vpn].valid || curr->page_flags[vpn] != 0;
+        run = in_use ? 0 : run + 1;
+        if (run == n) {
+            first_vpn = vpn;
+            break;
+        }
+    }
+    if (first_vpn == -1) {
+        TracePrintf(SYSCALLS_TRACE_LEVEL, "Shared_Pages: No free run of %d pages for process PID %d\n", n, curr->pid);
+        return 0;
+    }
+
+    for (int i = 0; i < n; i++) {
+        int pfn = allocZeroedFrame(FRAME_USER, curr->pid);
+        if (pfn == -1) {
+            TracePrintf(SYSCALLS_TRACE_LEVEL, "Shared_Pages: Out of frames for process PID %d\n", curr->pid);
+            for (int j = 0; j < i; j++) {
+                freeFrame(curr->ptbr[first_vpn + j].pfn);
+                curr->ptbr[first_vpn + j].valid = 0;
+                curr->page_flags[first_vpn + j] = 0;
+            }
+            WriteRegister(REG_TLB_FLUSH, TLB_FLUSH_1);
+            return 0;
+        }
+        MapPage(curr->ptbr, first_vpn + i, pfn, PROT_READ | PROT_WRITE);
+        curr->page_flags[first_vpn + i] = PAGE_SHARED;
+    }
+
+    TracePrintf(SYSCALLS_TRACE_LEVEL, "Shared_Pages: Mapped %d shared pages at vpn %d for process PID %d\n", n, first_vpn, curr->pid);
+    return VMEM_1_BASE + (first_vpn << PAGESHIFT);
+}
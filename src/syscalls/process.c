@@ -2,9 +2,16 @@
 #include "proc.h"
 #include "kernel.h"
 #include "mem.h"
+#include "image.h"
 #include "syscalls/process.h"
+#include "syscalls/tty.h"
+#include "syscalls/custom.h"
+#include "traps/trap.h"
+#include "sched.h"
+#include "timer.h"
 #include <hardware.h>
 #include <ykernel.h>
+#include <unistd.h>
 
 
 int Brk(void *addr) {
@@ -20,14 +27,21 @@ int Brk(void *addr) {
     unsigned int user_heap_brk_vpn = (aligned_user_heap_brk - VMEM_1_BASE) >> PAGESHIFT;
 
     pte_t *pt_region1 = current_process->ptbr;
+    // The heap may not grow into Shared_Pages memory
+    for (unsigned int vpn = user_heap_brk_vpn; vpn < target_vpn; vpn++) {
+        if (current_process->page_flags[vpn] & PAGE_SHARED) {
+            TracePrintf(SYSCALLS_TRACE_LEVEL, "Brk: Heap of process PID %d would overlap its shared pages!\n", current_process->pid);
+            return ERROR;
+        }
+    }
     // In case of growing the heap
     while (user_heap_brk_vpn < target_vpn) {
         if (pt_region1[user_heap_brk_vpn].valid == 1) {
             user_heap_brk_vpn++;
             continue;
         }
-        // Allocate new frame
-        int pfn = allocFrame(FRAME_USER, current_process->pid);
+        // Allocate new frame (heap pages must start out zeroed)
+        int pfn = allocZeroedFrame(FRAME_USER, current_process->pid);
         if (pfn == -1) {
             TracePrintf(SYSCALLS_TRACE_LEVEL, "Brk: Failed to allocate frames to expand user heap for process PID %d!\n", current_process->pid);
             // TODO: If we already allocated frames for this, free them
@@ -49,6 +63,7 @@ int Brk(void *addr) {
         }
         freeFrame(pt_region1[user_heap_brk_vpn].pfn);
         pt_region1[user_heap_brk_vpn].valid = 0; // Mark this mapping as invalid
+        current_process->page_flags[user_heap_brk_vpn] = 0;
         WriteRegister(REG_TLB_FLUSH, ((user_heap_brk_vpn) << PAGESHIFT) + VMEM_1_BASE); // Flushing it out from the TLB
         user_heap_brk_vpn++;
     }
@@ -67,14 +82,34 @@ int Fork (void) {
     }
     PCB *parent = current_process;
     child->ppid = parent->pid; // Mapping the pid of the parent to the ppid in the child
+    child->parent = parent;    // Set now, so an early Exit of the parent orphans the child properly
+    child->quantum = parent->quantum;
+    child->tickets = parent->tickets;
+    child->stride = parent->stride;
+    child->pass = parent->pass; // starts level with its parent instead of owing or being owed CPU time
 
     // Copy current `UserContext` from parent process PCB to child process's PCB
     memcpy(&child->user_context, &parent->user_context, sizeof(UserContext));
 
+    // Demand-paged pages the parent hasn't touched yet need their own handle on the executable
+    if (parent->exec_fd >= 0) {
+        child->exec_fd = dup(parent->exec_fd);
+    }
+    child->image = ImageDup(parent->image);
+
+    // Allocate the child's kernel stack here, where we may block to swap pages out, rather than in KCCopy
+    child->kstack = InitializeKernelStackProcess();
+    if (child->kstack == NULL) {
+        TracePrintf(0, "Fork: Failed to allocate a kernel stack for the child process!\n");
+        deletePCB(child);
+        return ERROR;
+    }
+
     // Now need to copy region1 pagetable
     int result = CopyPT(parent, child);
     if (result == ERROR) {
         TracePrintf(0, "Fork: Failed to clone region 1 memory into child process!\n");
+        deletePCB(child);
         return ERROR;
     }
     // Copy heap brk and all the user stuff
@@ -84,19 +119,18 @@ int Fork (void) {
 
     if (rc == -1) {
         TracePrintf(0, "Fork: Kernel Context Switch failed while copying kernel stack!\n");
+        deletePCB(child); // Never made runnable, so nothing else refers to it yet
         return ERROR;
     }
 
     // Because both parent and child execute this part after returning from context switch
     if (current_process->pid == parent->pid) {
         // If its the parent, set the child ready for scheduling
-        child->state = PROC_READY;
-        queueEnqueue(ready_queue, child);
+        SchedReady(child);
         queueEnqueue(parent->children_processes, child); // Also add it to the child processes queue of the parent
         (&current_process->user_context)->regs[0] = child->pid; // Return value for Fork for the parent (child's pid)
     } else {
         (&current_process->user_context)->regs[0] = 0; // Return value for Fork for the child (0)
-        current_process->parent = parent;
     }
 
     return SUCCESS;
@@ -105,37 +139,81 @@ int Fork (void) {
 
 int Exec(char *filename, char **argvec) {
     PCB *curr = current_process;
+
+    // The name and arguments may live on pages that haven't been demand-loaded yet
+    if (PrepareUserString(curr, filename) == ERROR) {
+        TracePrintf(0, "Exec: Process PID %d passed an invalid filename.\n", curr->pid);
+        return ERROR;
+    }
+    for (int i = 0; ; i++) {
+        if (PrepareUserRead(curr, &argvec[i], sizeof(char *)) == ERROR) {
+            return ERROR;
+        }
+        if (argvec[i] == NULL) break;
+        if (PrepareUserString(curr, argvec[i]) == ERROR) {
+            TracePrintf(0, "Exec: Process PID %d passed an invalid argument.\n", curr->pid);
+            return ERROR;
+        }
+    }
+
     int load_status = LoadProgram(filename, argvec, curr);
     if (load_status == ERROR) {
+        // Nothing has been torn down yet, so the caller's image (and filename) are still intact
         TracePrintf(0, "Exec: Process PID %d failed to execute %s.\n", curr->pid, filename);
         return ERROR;
     }
+    if (load_status != SUCCESS) {
+        // LoadProgram got past the point of no return: the old image is gone and the new one is half built
+        TracePrintf(0, "Exec: Process PID %d was left without a runnable image. Killing it.\n", curr->pid);
+        Exit(ERROR);
+    }
 
-    TracePrintf(0, "Exec: Succeded in executing %s for process PID %d.\n", filename, curr->pid);
+    // filename pointed into the old region 1, which has just been replaced
+    TracePrintf(0, "Exec: Succeded in executing a new program for process PID %d.\n", curr->pid);
     return SUCCESS;
 }
 
 void Exit (int status) {
-    // Need to handle orphan processes somehow
     PCB* curr = current_process;
     if (curr->pid == 1) {
         deletePCB(curr);
         Halt();
     }
 
-    queueEnqueue(zombie_queue, curr);
+    // Give back everything that doesn't live on the kernel stack we are running on
+    FreeRegion1(curr);
+    TtyReleaseProcess(curr);
+
+    // Orphan our children. Those already dead have nobody left to Wait for them, so they go away now
+    while (!is_empty(curr->children_processes)) {
+        PCB *child = queueDequeue(curr->children_processes);
+        child->parent = NULL;
+        child->ppid = INVALID_PID;
+        if (child->state == PROC_ZOMBIE) {
+            procListRemove(child);
+            if (!child->reap_pending) {
+                deletePCB(child);
+            }
+            // Otherwise the reaper deletes it together with its kernel stack
+        }
+    }
+
     curr->exit_status = status;
     curr->state = PROC_ZOMBIE;
-
-    PCB *parent = curr->parent;
-    if (parent && parent->waiting_for_child_pid) {
-        parent->state = PROC_READY;
-        parent->waiting_for_child_pid = 0;
-        queueEnqueue(ready_queue, parent);
+    if (curr->parent != NULL) {
+        procListEnqueue(&curr->parent->zombie_children, curr);
     }
 
+    // Our kernel stack can only be freed once we are off it
+    curr->reap_pending = 1;
+    queueEnqueue(reap_queue, curr);
+
     TracePrintf(0, "Exiting process PID %d and switching to a different process...\n", curr->pid);
-    PCB *next = is_empty(ready_queue) ? idle_proc : queueDequeue(ready_queue);
+    if (curr->parent != NULL) {
+        // A parent sleeping in Wait runs next, on what is left of our slice; this doesn't return
+        WaitQueueHandoff(WaitQueueWakeOne(&curr->parent->child_exit));
+    }
+    PCB *next = SchedPickNext();
     int rc = KernelContextSwitch(KCSwitch, curr, next);
     if (rc == -1) {
         TracePrintf(0, "Exit: Failed to switch context inside syscall Exit!\n");
@@ -144,53 +222,62 @@ void Exit (int status) {
 }
 
 
+// Hands a zombie child's exit status to its parent and frees what is left of it. If the status can't
+// be written the child is left a zombie, so a later Wait with a good pointer can still collect it
+static int reapChild(PCB *parent, PCB *zombie, int *status_ptr) {
+    TracePrintf(0, "Parent process PID %d reaping child zombie process PID %d\n", parent->pid, zombie->pid);
+    if (status_ptr != NULL) {
+        if (PinUserBuffer(parent, status_ptr, sizeof(int), PROT_WRITE) == ERROR) {
+            TracePrintf(0, "WaitPid: Status pointer of process PID %d is not writable. Not reaping PID %d.\n", parent->pid, zombie->pid);
+            return ERROR;
+        }
+        *status_ptr = zombie->exit_status;
+        UnpinUserBuffer(parent, status_ptr, sizeof(int));
+    }
+    int pid = zombie->pid;
+    queueRemove(parent->children_processes, zombie);
+    procListRemove(zombie);
+    deletePCB(zombie);
+    return pid;
+}
+
 int Wait (int * status_ptr) {
+    return WaitPid(-1, status_ptr, 0);
+}
+
+int WaitPid(int pid, int *status_ptr, int flags) {
     PCB *curr = current_process;
     if (curr->children_processes->head == NULL) {
-        TracePrintf(0, "Wait: Error! No children to wait on!\n");
+        TracePrintf(0, "WaitPid: Error! No children to wait on!\n");
         return ERROR;
     }
-
-    QueueNode_t *zombie_node = zombie_queue->head;
-    while (zombie_node != NULL) {
-        PCB *zombie_process = zombie_node->process;
-        if (zombie_process->ppid == curr->pid) {
-            TracePrintf(0, "Parent process PID %d reaping child zombie process PID %d\n", curr->pid, zombie_process->pid);
-            if (status_ptr != NULL) *status_ptr = zombie_process->exit_status;
-            int pid = zombie_process->pid;
-            queueRemove(curr->children_processes, zombie_process);
-            queueRemove(zombie_queue, zombie_process);
-            deletePCB(zombie_process);
-            return pid;
-        }
-        zombie_node = zombie_node->next;
+    if (status_ptr != NULL && CheckBuffer(status_ptr, sizeof(int)) == ERROR) {
+        TracePrintf(0, "WaitPid: Status pointer of process PID %d is outside region 1.\n", curr->pid);
+        return ERROR;
     }
 
-    curr->state = PROC_BLOCKED;
-    curr->waiting_for_child_pid = 1;
-    PCB *next = is_empty(ready_queue) ? idle_proc : queueDequeue(ready_queue);
-    int rc = KernelContextSwitch(KCSwitch, curr, next);
-    if (rc == -1) {
-        TracePrintf(0, "Wait: Failed to switch context inside syscall Wait!\n");
-        Halt();
+    PCB *child = NULL;
+    if (pid != -1) {
+        child = findPCB(pid);
+        if (child == NULL || child->parent != curr) {
+            TracePrintf(0, "WaitPid: Process PID %d is not a child of PID %d.\n", pid, curr->pid);
+            return ERROR;
+        }
     }
 
-    zombie_node = zombie_queue->head;
-    while (zombie_node != NULL) {
-        PCB *zombie_process = zombie_node->process;
-        if (zombie_process->ppid == curr->pid) {
-            TracePrintf(0, "Parent process PID %d reaping child zombie process PID %d\n", curr->pid, zombie_process->pid);
-            if (status_ptr != NULL) *status_ptr = zombie_process->exit_status;
-            int pid = zombie_process->pid;
-            queueRemove(curr->children_processes, zombie_process);
-            queueRemove(zombie_queue, zombie_process);
-            deletePCB(zombie_process);
-            return pid;
+    // Any child's exit wakes us, not just the one a WaitPid(pid) caller asked for, so recheck after each wakeup
+    while (1) {
+        if (child == NULL && !procListIsEmpty(&curr->zombie_children)) {
+            return reapChild(curr, curr->zombie_children.head, status_ptr);
         }
-        zombie_node = zombie_node->next;
+        if (child != NULL && child->state == PROC_ZOMBIE) {
+            return reapChild(curr, child, status_ptr);
+        }
+        if (flags & WAIT_NOHANG) {
+            return 0;
+        }
+        WaitQueueSleep(&curr->child_exit);
     }
-    return ERROR;
-
 }
 
 int GetPid (void) {
@@ -209,21 +296,52 @@ int Delay(int clock_ticks) {
 
     // Get the current running process to delay
     PCB *curr = current_process;
-    curr->delay_ticks = clock_ticks;
 
-    // Change its status to blocked and add it to blocked queue
-    curr->state = PROC_BLOCKED;
-    queueEnqueue(blocked_queue, curr);
-    
-    // Get the next ready process to run
-    PCB *next_proc = queueDequeue(ready_queue);
-    if (next_proc == NULL) {
-        next_proc = idle_proc;
-    }
-    
-    TracePrintf(SYSCALLS_TRACE_LEVEL, "Delay: Process PID %d is delayed. Switching to process PID %d...\n", curr->pid, next_proc->pid);
-    KernelContextSwitch(KCSwitch, curr, next_proc);
+    // Park it on the timer wheel until its tick comes (Delay(-1) never wakes up)
+    TracePrintf(SYSCALLS_TRACE_LEVEL, "Delay: Process PID %d is delayed for %d ticks.\n", curr->pid, clock_ticks);
+    TimerSleep(curr, clock_ticks);
 
     return SUCCESS;
 }
 
+PCB *ControlTarget(int pid, int allow_zombie) {
+    PCB *curr = current_process;
+    if (pid == 0 || pid == curr->pid) {
+        return curr;
+    }
+    PCB *process = findPCB(pid);
+    if (process == NULL || process->parent != curr) {
+        return NULL;
+    }
+    if (process->state == PROC_ZOMBIE && !allow_zombie) {
+        return NULL;
+    }
+    return process;
+}
+
+int SetQuantum(int pid, int ticks) {
+    PCB *target = ControlTarget(pid, 0);
+    if (target == NULL) {
+        TracePrintf(SYSCALLS_TRACE_LEVEL, "SetQuantum: Process PID %d can't change the quantum of PID %d.\n", current_process->pid, pid);
+        return ERROR;
+    }
+    return SchedSetQuantum(target, ticks);
+}
+
+int SetShare(int pid, int tickets) {
+    PCB *target = ControlTarget(pid, 0);
+    if (target == NULL) {
+        TracePrintf(SYSCALLS_TRACE_LEVEL, "SetShare: Process PID %d can't change the share of PID %d.\n", current_process->pid, pid);
+        return ERROR;
+    }
+    return SchedSetShare(target, tickets);
+}
+
+int GetTicks(int pid) {
+    PCB *target = ControlTarget(pid, 1);
+    if (target == NULL) {
+        TracePrintf(SYSCALLS_TRACE_LEVEL, "GetTicks: Process PID %d can't read the ticks of PID %d.\n", current_process->pid, pid);
+        return ERROR;
+    }
+    return target->cpu_ticks;
+}
@@ -1,9 +1,72 @@
 #include "syscalls/tty.h"
 #include "kernel.h"
+#include "sched.h"
+#include "mem.h"
 
 
 terminal_t terminals[NUM_TERMINALS];
 
+int tty_input_size = TTY_INPUT_DEFAULT_SIZE;
+
+int TtyInputRoundSize(int size) {
+   int rounded = TERMINAL_MAX_LINE;
+   while (rounded < size && rounded < TTY_INPUT_MAX_SIZE) {
+      rounded <<= 1;
+   }
+   return rounded;
+}
+
+int TtyInputAvailable(terminal_t *terminal) {
+   return terminal->read_tail - terminal->read_head;
+}
+
+int TtyInputAppend(terminal_t *terminal, char *data, int len) {
+   unsigned int mask = tty_input_size - 1;
+   int space = tty_input_size - TtyInputAvailable(terminal);
+   int stored = (len < space) ? len : space;
+   if (stored < len) {
+      terminal->read_dropped += len - stored;
+      TracePrintf(0, "TtyInputAppend: Terminal tty_id %d input ring full, dropped %d bytes.\n", terminal->tty_id, len - stored);
+   }
+
+   // The free space may wrap around the end of the ring: copy up to the end, then from the start
+   unsigned int start = terminal->read_tail & mask;
+   int first = (stored < tty_input_size - (int)start) ? stored : tty_input_size - (int)start;
+   memcpy(terminal->read_buffer + start, data, first);
+   memcpy(terminal->read_buffer, data + first, stored - first);
+   terminal->read_tail += stored;
+   return stored;
+}
+
+int TtyInputDeliver(terminal_t *terminal, PCB *reader, int len) {
+   unsigned int mask = tty_input_size - 1;
+   int available = TtyInputAvailable(terminal);
+   int taken = (len < available) ? len : available;
+
+   unsigned int start = terminal->read_head & mask;
+   int first = (taken < tty_input_size - (int)start) ? taken : tty_input_size - (int)start;
+   char *dst = (char *)reader->tty_read_buf;
+   if (CopyToProcess(reader, dst, terminal->read_buffer + start, first) == ERROR ||
+       CopyToProcess(reader, dst + first, terminal->read_buffer, taken - first) == ERROR) {
+      return 0;
+   }
+   terminal->read_head += taken;
+   return taken;
+}
+
+int TtyInputConsume(terminal_t *terminal, char *dst, int len) {
+   unsigned int mask = tty_input_size - 1;
+   int available = TtyInputAvailable(terminal);
+   int taken = (len < available) ? len : available;
+
+   unsigned int start = terminal->read_head & mask;
+   int first = (taken < tty_input_size - (int)start) ? taken : tty_input_size - (int)start;
+   memcpy(dst, terminal->read_buffer + start, first);
+   memcpy(dst + first, terminal->read_buffer, taken - first);
+   terminal->read_head += taken;
+   return taken;
+}
+
 int BeginTtyTransmit(int tty_id, PCB *writer, void *buf, int len) {
    TracePrintf(0, "BeginTtyTransmit: Process PID %d starting to write %d bytes to terminal tty_id %d.\n", writer->pid, len, tty_id);
    
@@ -40,52 +103,45 @@ int TtyRead(int tty_id, void *buf, int len) {
    PCB *curr = current_process;
    TracePrintf(0, "Kernel: Executing TtyRead syscall for process PID %d...\n", curr->pid);
 
-   // If there's already data to read from terminal, return immediately
-   if (terminal->read_buffer_len > 0) {
-      int bytes_to_read = (len > terminal->read_buffer_len) ? terminal->read_buffer_len : len; // Number of bytes to read
-      TracePrintf(0, "TtyRead: Reading %d bytes from terminal %d into process PID %d.\n", bytes_to_read, terminal->tty_id, curr->pid);
-
-      // Temporary kernel buffer to hold this data
-      char *kernel_buffer = malloc(bytes_to_read);
-      if (kernel_buffer == NULL) {
-         TracePrintf(0, "TtyRead: Failed to allocate space for kernel buffer!\n");
-         return ERROR;
+   while (1) {
+      // If there's already data to read from terminal, return immediately
+      if (TtyInputAvailable(terminal) > 0) {
+         // Bring the buffer in and pin it just for the copy. That may block on swap I/O, so check again after
+         if (PinUserBuffer(curr, buf, len, PROT_WRITE) == ERROR) {
+            TracePrintf(0, "TtyRead: Could not make the buffer of process PID %d writable.\n", curr->pid);
+            return ERROR;
+         }
+         int bytes_to_read = 0;
+         if (TtyInputAvailable(terminal) > 0) {
+            bytes_to_read = TtyInputConsume(terminal, buf, len); // We are the reader, so the buffer is mapped right here
+         }
+         UnpinUserBuffer(curr, buf, len);
+         if (bytes_to_read > 0) {
+            TracePrintf(0, "TtyRead: Returning %d bytes for process PID %d. %d remaining in terminal tty_id %d.\n", bytes_to_read, curr->pid, TtyInputAvailable(terminal), terminal->tty_id);
+            return bytes_to_read;
+         }
+         // Another reader took the input while we were paging in; wait for more
       }
-
-      // Copy a number of "bytes_to_read" from the terminal read buffer into our kernel buffer
-      memcpy(kernel_buffer, terminal->read_buffer, bytes_to_read);
-      curr->tty_kernel_read_buf = kernel_buffer;
-      curr->kernel_read_size = bytes_to_read;
-
-      if (bytes_to_read < terminal->read_buffer_len) {
-         memmove(terminal->read_buffer, terminal->read_buffer + bytes_to_read,  terminal->read_buffer_len - bytes_to_read);
+      // If there's no data available to be read, block the current process, add it to the waiting queue in the terminal to be woken up later
+      // when there's data to read.
+      TracePrintf(0, "TtyRead: No data available to read for process PID %d at terminal tty_id %d. Blocking process.\n", curr->pid, terminal->tty_id);
+
+      // Store the buffer to copy to and also how many bytes needed to read in the process PCB; the
+      // receive trap copies the data straight into it if the buffer is still resident by then
+      curr->tty_read_buf = buf;
+      curr->tty_read_len = len;
+      curr->user_context.regs[0] = 0;
+
+      // Sleep on this terminal's readers until the receive trap hands us some data. Nothing is pinned while we sleep
+      SchedBlockedOnIO(curr);
+      WaitQueueSleep(&terminal->blocked_readers);
+
+      TracePrintf(0, "TtyRead: process PID %d woken up.\n", curr->pid);
+      if (curr->user_context.regs[0] > 0) {
+         return curr->user_context.regs[0];
       }
-      terminal->read_buffer_len -= bytes_to_read;
-      TracePrintf(0, "TtyRead: Returning %d bytes for process PID %d. %d remaining in terminal tty_id %d.\n", bytes_to_read, curr->pid, terminal->read_buffer_len, terminal->tty_id);
-
-      return bytes_to_read;
+      // Part of the buffer was swapped out when the input came, so the data is still in the ring for us to copy
    }
-   // If there's no data available to be read, block the current process, add it to the waiting queue in the terminal to be woken up later
-   // when there's data to read.
-   TracePrintf(0, "TtyRead: No data available to read for process PID %d at terminal tty_id %d. Blocking process.\n", curr->pid, terminal->tty_id);
-   
-   // Add it to queue of blocked readers for this terminal
-   queueEnqueue(terminal->blocked_readers, curr);
-
-   // Block the process
-   queueEnqueue(blocked_queue, curr);
-   curr->state = PROC_BLOCKED;
-
-   // Store the buffer to copy to and also how many bytes needed to read in the process PCB for when the process is woken up
-   curr->tty_read_buf = buf;
-   curr->tty_read_len = len;
-
-   // Switch to idle or another process
-   PCB *next = (is_empty(ready_queue) == 1) ? idle_proc : queueDequeue(ready_queue);
-   KernelContextSwitch(KCSwitch, curr, next);
-
-   TracePrintf(0, "TtyRead: process PID %d woken up.\n", curr->pid);
-   return curr->user_context.regs[0];
 }
 
 int TtyWrite(int tty_id, void *buf, int len) {
@@ -102,14 +158,9 @@ int TtyWrite(int tty_id, void *buf, int len) {
    if (terminal->in_use) {
       TracePrintf(0, "TtyWrite: Terminal %d busy. PID %d waiting for lock.\n", tty_id, curr->pid);
       
-      queueEnqueue(terminal->blocked_writers, curr);
-      
       // Block purely for the lock
-      curr->state = PROC_BLOCKED;
-      queueEnqueue(blocked_queue, curr);
-      
-      PCB *next = (is_empty(ready_queue)) ? idle_proc : queueDequeue(ready_queue);
-      KernelContextSwitch(KCSwitch, curr, next);
+      SchedBlockedOnIO(curr);
+      WaitQueueSleep(&terminal->blocked_writers);
       // WAKE UP! If we get here, the trap handler dequeued us and woke us up
       // It's our turn to write to the terminal
    }
@@ -120,33 +171,40 @@ int TtyWrite(int tty_id, void *buf, int len) {
    // Copy the data from the buffer into the kernel-allocated array in terminal->write_buffer
    TracePrintf(0, "TtyWrite: PID %d acquired terminal %d. Starting copy.\n", curr->pid, tty_id);
    
-   // Allocation and memcpy happen here
-   int result = BeginTtyTransmit(tty_id, curr, buf, len);
-   
+   // Allocation and memcpy happen here, with the buffer pinned just for the copy
+   int result = PinUserBuffer(curr, buf, len, PROT_READ);
+   if (result == ERROR) {
+      TracePrintf(0, "TtyWrite: Could not bring in the buffer of process PID %d.\n", curr->pid);
+   } else {
+      result = BeginTtyTransmit(tty_id, curr, buf, len);
+      UnpinUserBuffer(curr, buf, len);
+   }
+
    if (result == ERROR) {
-      TracePrintf(0, "TtyWrite: Allocation failed for PID %d\n", curr->pid);
+      TracePrintf(0, "TtyWrite: Copy failed for PID %d\n", curr->pid);
       // Release the lock so other processes are not stuck forever
       terminal->in_use = 0;
       
       // If others are waiting, wake the next one immediately
-      if (!is_empty(terminal->blocked_writers)) {
-          PCB *next_writer = queueDequeue(terminal->blocked_writers);
-          next_writer->state = PROC_READY;
-          queueEnqueue(ready_queue, next_writer);
-      }
+      WaitQueueWakeOne(&terminal->blocked_writers);
       return ERROR;
    }
 
    // Wait for I/O completion. We sleep again until the trap handler says "All chunks done".
    TracePrintf(0, "TtyWrite: PID %d waiting for I/O completion...\n", curr->pid);
    
-   curr->state = PROC_BLOCKED;
-   queueEnqueue(blocked_queue, curr);
-   
-   PCB *next = (is_empty(ready_queue)) ? idle_proc : queueDequeue(ready_queue);
-   KernelContextSwitch(KCSwitch, curr, next);
+   SchedBlockedOnIO(curr);
+   WaitQueueSleep(&terminal->write_done);
 
    // Done!! The trap handler woke us up.
    TracePrintf(0, "TtyWrite: PID %d write complete.\n", curr->pid);
    return len;
-}
\ No newline at end of file
+}
+
+void TtyReleaseProcess(PCB *proc) {
+   for (int i = 0; i < NUM_TERMINALS; i++) {
+      if (terminals[i].current_writer == proc) {
+         terminals[i].current_writer = NULL;
+      }
+   }
+}
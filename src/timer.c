@@ -0,0 +1,40 @@
+#include "timer.h"
+#include "sched.h"
+#include <ykernel.h>
+
+unsigned int timer_ticks = 0;
+
+static wait_queue_t timer_wheel[TIMER_WHEEL_SLOTS];
+static wait_queue_t timer_forever; // TimerSleep(proc, -1); nothing ever wakes it
+
+void InitializeTimerWheel(void) {
+    for (int i = 0; i < TIMER_WHEEL_SLOTS; i++) {
+        WaitQueueInit(&timer_wheel[i], "timer wheel");
+    }
+    WaitQueueInit(&timer_forever, "delay forever");
+}
+
+void TimerSleep(PCB *proc, int ticks) {
+    if (ticks < 0) {
+        WaitQueueSleep(&timer_forever);
+        return;
+    }
+    proc->wake_tick = timer_ticks + ticks;
+    WaitQueueSleep(&timer_wheel[proc->wake_tick % TIMER_WHEEL_SLOTS]);
+}
+
+void TimerTick(void) {
+    timer_ticks++;
+    wait_queue_t *slot = &timer_wheel[timer_ticks % TIMER_WHEEL_SLOTS];
+
+    PCB *process = slot->sleepers.head;
+    while (process != NULL) {
+        PCB *next_process = process->next;
+        // Sleepers a whole turn (or more) away share the slot; leave them for their own tick
+        if ((int)(timer_ticks - process->wake_tick) >= 0) {
+            TracePrintf(0, "Process PID %d delay has elapsed!\n", process->pid);
+            WaitQueueWake(process);
+        }
+        process = next_process;
+    }
+}
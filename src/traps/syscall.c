@@ -0,0 +1,276 @@
+#include "traps/syscall.h"
+#include "traps/trap.h"
+#include "kernel.h"
+#include "proc.h"
+#include "mem.h"
+#include "syscalls/process.h"
+#include "syscalls/tty.h"
+#include "syscalls/shared_pages.h"
+#include "syscalls/custom.h"
+#include "timer.h"
+#include <hardware.h>
+#include <ykernel.h>
+
+/*
+ * Argument decoding, one per syscall. uctx is the caller's saved context; a handler that
+ * may block or fork reads its arguments before doing so and afterwards only looks at
+ * current_process.
+ */
+
+static int SysFork(UserContext *uctx) {
+    if (Fork() == ERROR) {
+        TracePrintf(TRAP_TRACE_LEVEL, "Failed to execute Fork syscall!\n");
+        return ERROR;
+    }
+    // Fork already stored the child's pid (parent) or 0 (child) in whichever process we are now
+    return current_process->user_context.regs[0];
+}
+
+static int SysExec(UserContext *uctx) {
+    return Exec((char *)uctx->regs[0], (char **)uctx->regs[1]);
+}
+
+static int SysExit(UserContext *uctx) {
+    Exit(uctx->regs[0]);
+    return ERROR; // not reached
+}
+
+static int SysWait(UserContext *uctx) {
+    return Wait((int *)uctx->regs[0]);
+}
+
+static int SysGetPid(UserContext *uctx) {
+    return GetPid();
+}
+
+static int SysBrk(UserContext *uctx) {
+    int brk_result = Brk((void *)uctx->regs[0]);
+    if (brk_result == ERROR) {
+        // e.g. out of frames or running into Shared_Pages memory; the caller gets ERROR back
+        TracePrintf(TRAP_TRACE_LEVEL, "Failed to execute Brk syscall!\n");
+    }
+    return brk_result;
+}
+
+static int SysDelay(UserContext *uctx) {
+    TracePrintf(0, "process PID %d delaying for %d ticks\n", current_process->pid, uctx->regs[0]);
+    return Delay(uctx->regs[0]);
+}
+
+static int SysTtyRead(UserContext *uctx) {
+    int tty_id = uctx->regs[0];
+    void *buf = (void *)uctx->regs[1];
+    int len = uctx->regs[2];
+
+    // Ensure pointer is in User Space
+    if (CheckBuffer(buf, len) == ERROR) {
+        TracePrintf(0, "Trap: Illegal memory access in TtyRead by PID %d\n", current_process->pid);
+        return ERROR;
+    }
+
+    return TtyRead(tty_id, buf, len);
+}
+
+static int SysTtyWrite(UserContext *uctx) {
+    int tty_id = uctx->regs[0];
+    void *buf = (void *)uctx->regs[1];
+    int len = uctx->regs[2];
+
+    // Ensure we aren't printing kernel memory secrets
+    if (CheckBuffer(buf, len) == ERROR) {
+        TracePrintf(0, "Trap: Illegal memory access in TtyWrite by PID %d\n", current_process->pid);
+        return ERROR;
+    }
+    return TtyWrite(tty_id, buf, len);
+}
+
+static int SysSharedPages(UserContext *uctx) {
+    return Shared_Pages(uctx->regs[0]);
+}
+
+static int SysWaitPid(UserContext *uctx) {
+    return WaitPid(uctx->regs[0], (int *)uctx->regs[1], uctx->regs[2]);
+}
+
+static int SysSchedControl(UserContext *uctx) {
+    switch (uctx->regs[0]) {
+        case SCHED_OP_SET_QUANTUM:
+            return SetQuantum(uctx->regs[1], uctx->regs[2]);
+        case SCHED_OP_SET_SHARE:
+            return SetShare(uctx->regs[1], uctx->regs[2]);
+        case SCHED_OP_GET_TICKS:
+            return GetTicks(uctx->regs[1]);
+    }
+    return ERROR;
+}
+
+static int SysKernelOp(UserContext *uctx);
+
+#define SYSCALL(code, fn, flags, slot) [(code) & YALNIX_MASK] = { #fn, fn, flags, slot }
+
+syscall_entry_t syscall_table[SYSCALL_TABLE_SIZE] = {
+    SYSCALL(YALNIX_FORK, SysFork, SYSCALL_NO_BATCH, SYSCALL_STAT_FORK),
+    SYSCALL(YALNIX_EXEC, SysExec, SYSCALL_NO_BATCH, SYSCALL_STAT_EXEC),
+    SYSCALL(YALNIX_EXIT, SysExit, SYSCALL_NO_BATCH, SYSCALL_STAT_EXIT),
+    SYSCALL(YALNIX_WAIT, SysWait, SYSCALL_MAY_BLOCK, SYSCALL_STAT_WAIT),
+    SYSCALL(YALNIX_GETPID, SysGetPid, 0, SYSCALL_STAT_GETPID),
+    SYSCALL(YALNIX_BRK, SysBrk, 0, SYSCALL_STAT_BRK),
+    SYSCALL(YALNIX_DELAY, SysDelay, SYSCALL_MAY_BLOCK, SYSCALL_STAT_DELAY),
+    SYSCALL(YALNIX_TTY_READ, SysTtyRead, SYSCALL_MAY_BLOCK, SYSCALL_STAT_TTY_READ),
+    SYSCALL(YALNIX_TTY_WRITE, SysTtyWrite, SYSCALL_MAY_BLOCK, SYSCALL_STAT_TTY_WRITE),
+    SYSCALL(YALNIX_SHARED_PAGES, SysSharedPages, 0, SYSCALL_STAT_SHARED_PAGES),
+    SYSCALL(YALNIX_CUSTOM_0, SysWaitPid, SYSCALL_MAY_BLOCK, SYSCALL_STAT_WAITPID),
+    SYSCALL(YALNIX_CUSTOM_1, SysSchedControl, 0, SYSCALL_STAT_SCHED_CONTROL),
+    SYSCALL(YALNIX_CUSTOM_2, SysKernelOp, SYSCALL_NO_BATCH, SYSCALL_STAT_KERNEL_OP),
+};
+
+syscall_stat_t syscall_stats[SYSCALL_STAT_SLOTS];
+
+static void statRecord(syscall_stat_t *stat, int result, int blocked, unsigned int ticks) {
+    if (result == ERROR) {
+        stat->errors++;
+    }
+    if (blocked) {
+        stat->blocked++;
+    }
+    stat->total_ticks += ticks;
+    if (ticks > stat->max_ticks) {
+        stat->max_ticks = ticks;
+    }
+}
+
+// Runs one syscall for the current process and charges it to the per-process and system counters
+static int syscallRun(syscall_entry_t *entry, UserContext *uctx) {
+    PCB *curr = current_process;
+    unsigned int start_tick = timer_ticks;
+    unsigned int start_switches = curr->switches_out;
+
+    // Counted up front, since Exit never comes back
+    curr->syscall_stats[entry->stat_slot].calls++;
+    syscall_stats[entry->stat_slot].calls++;
+
+    int result = entry->handler(uctx);
+
+    // A Fork child returns through here as well, on a copy of its parent's stack; the call is the parent's
+    if (current_process == curr) {
+        int blocked = (curr->switches_out != start_switches);
+        unsigned int ticks = timer_ticks - start_tick;
+        statRecord(&curr->syscall_stats[entry->stat_slot], result, blocked, ticks);
+        statRecord(&syscall_stats[entry->stat_slot], result, blocked, ticks);
+    }
+    return result;
+}
+
+// The table entry for a syscall number, or NULL if the kernel doesn't implement it
+static syscall_entry_t *syscallLookup(unsigned int code) {
+    if ((code & ~YALNIX_MASK) != YALNIX_PREFIX || syscall_table[code & YALNIX_MASK].handler == NULL) {
+        return NULL;
+    }
+    return &syscall_table[code & YALNIX_MASK];
+}
+
+// Runs up to n descriptors from the caller's memory, see KERNEL_OP_BATCH
+static int SysBatch(syscall_desc_t *descs, int n) {
+    if (n < 0 || n > SYSCALL_BATCH_MAX || CheckBuffer(descs, n * sizeof(syscall_desc_t)) == ERROR) {
+        TracePrintf(0, "SysBatch: Process PID %d passed a bad batch.\n", current_process->pid);
+        return ERROR;
+    }
+
+    int done = 0;
+    while (done < n) {
+        syscall_desc_t *desc = &descs[done];
+        // Checked again every time: an earlier entry may have slept while the page was swapped out
+        if (PrepareUserWrite(current_process, desc, sizeof(syscall_desc_t)) == ERROR) {
+            break;
+        }
+        syscall_entry_t *entry = syscallLookup(desc->code);
+
+        UserContext args;
+        memset(&args, 0, sizeof(args));
+        args.code = desc->code;
+        memcpy(args.regs, desc->args, sizeof(desc->args));
+
+        int result = ERROR;
+        if (entry != NULL && !(entry->flags & SYSCALL_NO_BATCH)) {
+            TracePrintf(TRAP_TRACE_LEVEL, "SysBatch: Entry %d runs %s for process PID %d\n", done, entry->name, current_process->pid);
+            result = syscallRun(entry, &args);
+        }
+
+        if (PrepareUserWrite(current_process, &desc->result, sizeof(int)) == ERROR) {
+            break;
+        }
+        desc->result = result;
+        done++;
+        if (entry == NULL || (entry->flags & (SYSCALL_MAY_BLOCK | SYSCALL_NO_BATCH))) {
+            break;
+        }
+    }
+    return done;
+}
+
+// Copies the counters of a process (pid -1: the whole system) out to the caller, see KERNEL_OP_STATS
+static int SysStats(int pid, syscall_stat_t *stats, int n) {
+    syscall_stat_t *source = syscall_stats;
+    if (pid != -1) {
+        PCB *target = ControlTarget(pid, 1);
+        if (target == NULL) {
+            return ERROR;
+        }
+        source = target->syscall_stats;
+    }
+    if (n > SYSCALL_STAT_SLOTS) {
+        n = SYSCALL_STAT_SLOTS;
+    }
+    if (n < 0 || CheckBuffer(stats, n * sizeof(syscall_stat_t)) == ERROR ||
+        PrepareUserWrite(current_process, stats, n * sizeof(syscall_stat_t)) == ERROR) {
+        return ERROR;
+    }
+    memcpy(stats, source, n * sizeof(syscall_stat_t));
+    return SYSCALL_STAT_SLOTS;
+}
+
+// Copies the physical memory counters out to the caller, see KERNEL_OP_MEM_STATS
+static int SysMemStats(mem_stat_t *stats) {
+    if (CheckBuffer(stats, sizeof(mem_stat_t)) == ERROR ||
+        PrepareUserWrite(current_process, stats, sizeof(mem_stat_t)) == ERROR) {
+        return ERROR;
+    }
+    stats->free_frames = free_nframes;
+    stats->zeroed_frames = zeroed_nframes;
+    stats->zero_pool_hits = zero_pool_hits;
+    stats->zero_pool_misses = zero_pool_misses;
+    return SUCCESS;
+}
+
+static int SysKernelOp(UserContext *uctx) {
+    switch (uctx->regs[0]) {
+        case KERNEL_OP_BATCH:
+            return SysBatch((syscall_desc_t *)uctx->regs[1], uctx->regs[2]);
+        case KERNEL_OP_STATS:
+            return SysStats(uctx->regs[1], (syscall_stat_t *)uctx->regs[2], uctx->regs[3]);
+        case KERNEL_OP_MEM_STATS:
+            return SysMemStats((mem_stat_t *)uctx->regs[1]);
+    }
+    return ERROR;
+}
+
+void KernelTrapHandler(UserContext* ctx) {
+    PCB *curr = current_process;
+    unsigned int code = ctx->code;
+    syscall_entry_t *entry = syscallLookup(code);
+    if (entry == NULL) {
+        TracePrintf(0, "KernelTrapHandler: Process PID %d made unknown syscall 0x%x\n", curr->pid, code);
+        ctx->regs[0] = ERROR;
+        return;
+    }
+
+    // Saved once: handlers may block, fork or switch, and read their arguments from here
+    memcpy(&curr->user_context, ctx, sizeof(UserContext));
+    TracePrintf(TRAP_TRACE_LEVEL, "Executing %s for process PID %d\n", entry->name, curr->pid);
+
+    int result = syscallRun(entry, &curr->user_context);
+
+    // Restored once, from whoever is running now
+    current_process->user_context.regs[0] = result;
+    memcpy(ctx, &current_process->user_context, sizeof(UserContext));
+}
@@ -7,178 +7,48 @@
 #include "syscalls/process.h"
 #include <hardware.h> 
 #include "syscalls/tty.h"
+#include "swap.h"
+#include "sched.h"
+#include "timer.h"
 
-void trapHandlerHelper(void *arg, PCB *process);
 int growStack(unsigned int addr);
-int CheckBuffer(void *addr, int len);
 
 void ClockTrapHandler(UserContext* ctx) {
    // Checkpoint 2: Temporary code
-   TracePrintf(0, "[CLOCK_TRAP] Clock trap triggered. Ticks: 0x%d\n", (int32_t)(tick_count));
+   TracePrintf(TRAP_TRACE_LEVEL, "[CLOCK_TRAP] Clock trap triggered. Ticks: 0x%d\n", (int32_t)(tick_count));
 
    PCB *curr = current_process;
    memcpy(&curr->user_context, ctx, sizeof(UserContext));
-   queueIterate(blocked_queue, NULL, trapHandlerHelper);
+   TimerTick(); // wakes only the Delay sleepers whose time is up
 
-   // For cp3, lets swap out processes at every clock tick
-   PCB *next_proc = queueDequeue(ready_queue);
+   // Free the kernel stacks of processes that exited since the last tick
+   ReapExitedProcesses();
 
-   // If we found another ready process, switch out to it
-   if (next_proc) {
-      TracePrintf(0, "Switching from PID %d to PID %d\n", curr->pid, next_proc->pid);
-      
-      // If current was running, put it back in ready status and put in ready queue
-      if (curr->state == PROC_RUNNING && curr->pid != 0) {
-         curr->state = PROC_READY;
-         queueEnqueue(ready_queue, curr);
+   // Nothing else wants the CPU, so spend the idle tick zeroing free frames for Brk/stack growth
+   if (curr == idle_proc) {
+      RefillZeroPool(ZERO_FRAMES_PER_IDLE_TICK);
+   }
+
+   // Switch away once the quantum is used up or a higher priority process is waiting
+   if (SchedTick(curr) && SchedHasReady()) {
+      // If current was running, put it back in ready status and let the policy choose among
+      // everybody, itself included (stride may well pick it again)
+      if (curr->state == PROC_RUNNING && curr != idle_proc) {
+         SchedReady(curr);
+      }
+      PCB *next_proc = SchedPickNext();
+      if (next_proc == curr) {
+         curr->state = PROC_RUNNING;
+      } else {
+         TracePrintf(0, "Switching from PID %d to PID %d\n", curr->pid, next_proc->pid);
+         KernelContextSwitch(KCSwitch, curr, next_proc);
       }
-      KernelContextSwitch(KCSwitch, curr, next_proc);
    }
 
 
    memcpy(ctx, &current_process->user_context, sizeof(UserContext));
 }
 
-void KernelTrapHandler(UserContext* ctx) {
-    int syscall_number = ctx->code;
-    switch (syscall_number) {
-        case YALNIX_DELAY: {
-            TracePrintf(TRAP_TRACE_LEVEL, "Yalnix Delay Syscall Handler\n");
-            TracePrintf(0, "process PID %d delaying for %d ticks\n", current_process->pid, ctx->regs[0]);
-            int delay = ctx->regs[0];
-            memcpy(&current_process->user_context, ctx, sizeof(UserContext));
-
-            int delay_result = Delay(delay);
-            if (delay_result == ERROR) {
-                TracePrintf(TRAP_TRACE_LEVEL, "ERROR: Failed to execute delay syscall!\n");
-                Halt();
-            }
-
-            memcpy(ctx, &current_process->user_context, sizeof(UserContext));
-            ctx->regs[0] = delay_result;
-            break;
-        }
-        case YALNIX_BRK: {
-            TracePrintf(0, "Executing Brk syscall for process PID %d\n", current_process->pid);
-            memcpy(&current_process->user_context, ctx, sizeof(UserContext));
-            
-            void *addr = (void *)ctx->regs[0];
-            int brk_result = Brk(addr);
-            if (brk_result == ERROR) {
-                TracePrintf(TRAP_TRACE_LEVEL, "Failed to execute Brk syscall!\n");
-                Halt();
-            }
-            memcpy(ctx, &current_process->user_context, sizeof(UserContext));
-            ctx->regs[0] = brk_result;
-            break;
-        }
-         case YALNIX_FORK: {
-            TracePrintf(TRAP_TRACE_LEVEL, "Executing Fork syscall for process PID %d\n", current_process->pid);
-            memcpy(&current_process->user_context, ctx, sizeof(UserContext));
-            int fork_result = Fork();
-            if (fork_result == ERROR) {
-               TracePrintf(TRAP_TRACE_LEVEL, "Failed to execute Fork syscall!\n");
-               Halt();
-            }
-            memcpy(ctx, &current_process->user_context, sizeof(UserContext));
-            break;
-         }
-         case YALNIX_GETPID: {
-            TracePrintf(TRAP_TRACE_LEVEL, "Executing GetPid syscall for process PID %d\n", current_process->pid);
-            memcpy(&current_process->user_context, ctx, sizeof(UserContext));
-            int pid_result = GetPid();
-            if (pid_result == -1) {
-               TracePrintf(0, "Failed to execute syscall GetPid!\n");
-               Halt();
-            }
-            memcpy(ctx, &current_process->user_context, sizeof(UserContext));
-            ctx->regs[0] = pid_result;
-            break;
-         }
-         case YALNIX_WAIT: {
-            TracePrintf(TRAP_TRACE_LEVEL, "Executing Wait syscall for process PID %d\n", current_process->pid);
-            memcpy(&current_process->user_context, ctx, sizeof(UserContext));
-            int *status_ptr = (int *)ctx->regs[0];
-            int wait_pid = Wait(status_ptr);
-            memcpy(ctx, &current_process->user_context, sizeof(UserContext));
-            ctx->regs[0] = wait_pid;
-            break;
-         }
-         case YALNIX_EXIT: {
-            TracePrintf(TRAP_TRACE_LEVEL, "Executing Exit syscall for process PID %d\n", current_process->pid);
-            int exit_status = ctx->regs[0];
-            Exit(exit_status);
-            break;
-         }
-         case YALNIX_EXEC: {
-            TracePrintf(TRAP_TRACE_LEVEL, "Executing Exec syscall for process PID %d\n", current_process->pid);
-            char *filename = (char *)ctx->regs[0];
-            char **argvec = (char **)ctx->regs[1];
-            memcpy(&current_process->user_context, ctx, sizeof(UserContext));
-            int exec_result = Exec(filename, argvec);
-            memcpy(ctx, &current_process->user_context, sizeof(UserContext));
-            ctx->regs[0] = exec_result;
-            break;
-         }
-         case YALNIX_TTY_READ: {
-            TracePrintf(TRAP_TRACE_LEVEL, "Executing TtyRead syscall for process PID %d\n", current_process->pid);
-            int tty_id = ctx->regs[0];
-            void *buf = (void *)ctx->regs[1];
-            int len = ctx->regs[2];
-
-            // Ensure pointer is in User Space
-            if (CheckBuffer(buf, len) == ERROR) {
-                TracePrintf(0, "Trap: Illegal memory access in TtyRead by PID %d\n", current_process->pid);
-                ctx->regs[0] = ERROR;
-                break;
-            }
-
-            // 2. Save Context (Crucial because TtyRead might block)
-            memcpy(&current_process->user_context, ctx, sizeof(UserContext));
-
-            // 3. Execute Logic
-            int rc = TtyRead(tty_id, buf, len);
-
-            // 4. Unpack Data (The "Backpack" Step)
-            // If TtyRead returned success, we might have data sitting in the kernel stash.
-            if (rc > 0 && current_process->tty_kernel_read_buf != NULL) {
-               memcpy(buf, current_process->tty_kernel_read_buf, current_process->kernel_read_size);
-               
-               // Cleanup the stash
-               free(current_process->tty_kernel_read_buf);
-               current_process->tty_kernel_read_buf = NULL;
-               current_process->kernel_read_size = 0;
-            }
-
-            // 5. Restore Context and Set Return Value
-            memcpy(ctx, &current_process->user_context, sizeof(UserContext));
-            ctx->regs[0] = rc;
-            break;
-         }
-         case YALNIX_TTY_WRITE: {
-            TracePrintf(TRAP_TRACE_LEVEL, "Executing TtyWrite syscall for process PID %d\n", current_process->pid);
-            int tty_id = ctx->regs[0];
-            void *buf = (void *)ctx->regs[1];
-            int len = ctx->regs[2];
-
-            // Ensure we aren't printing kernel memory secrets
-            if (CheckBuffer(buf, len) == ERROR) {
-                TracePrintf(0, "Trap: Illegal memory access in TtyWrite by PID %d\n", current_process->pid);
-                ctx->regs[0] = ERROR;
-                break;
-            }
-
-            memcpy(&current_process->user_context, ctx, sizeof(UserContext));
-            int rc = TtyWrite(tty_id, buf, len);
-            memcpy(ctx, &current_process->user_context, sizeof(UserContext));
-            ctx->regs[0] = rc;
-            break;
-         }
-
-    }
-
-}
-
 void MathTrapHandler(UserContext* ctx) {
    TracePrintf(0, "Kernel: Math trap in PID %d at user PC 0x%x. Terminating process.\n", current_process->pid, ctx->pc);
    Exit(ERROR); // Killing the process
@@ -193,15 +63,40 @@ void NotImplementedTrapHandler(UserContext* ctx) {}
 
 
 void DiskTrapHandler(UserContext* ctx) {
-    NotImplementedTrapHandler(ctx);
+    // The only disk user is the swap subsystem
+    SwapDiskInterrupt();
 }
 
 
 void MemoryTrapHandler(UserContext* ctx) {
    unsigned int fault_addr = (unsigned int)ctx->addr;
    TracePrintf(0, "Fault address is %u\n", fault_addr);
+
+   // Resolving the fault may block on the disk (swap in, or evicting to make room), so save the context
+   memcpy(&current_process->user_context, ctx, sizeof(UserContext));
+
    unsigned int user_heap_limit_addr = UP_TO_PAGE((unsigned int)(current_process->user_heap_end_vaddr));
    unsigned int user_stack_base_addr = DOWN_TO_PAGE((unsigned int)(current_process->user_stack_base_vaddr));
+   // First touch of a demand-paged text/data page, or a page that was swapped out to disk
+   if (ctx->code == YALNIX_MAPERR && fault_addr >= VMEM_1_BASE && fault_addr < VMEM_1_LIMIT) {
+      int fault_vpn = (DOWN_TO_PAGE(fault_addr) - VMEM_1_BASE) >> PAGESHIFT;
+      if (current_process->page_flags[fault_vpn] & PAGE_LAZY) {
+         if (LoadLazyPage(current_process, fault_vpn) == ERROR) {
+            TracePrintf(0, "Kernel: Memory trap handler killing process PID %d because it could not load a demand-paged page!\n", current_process->pid);
+            Exit(ERROR);
+         }
+         memcpy(ctx, &current_process->user_context, sizeof(UserContext));
+         return;
+      }
+      if (current_process->page_flags[fault_vpn] & PAGE_SWAPPED) {
+         if (SwapIn(current_process, fault_vpn) == ERROR) {
+            TracePrintf(0, "Kernel: Memory trap handler killing process PID %d because it could not swap a page back in!\n", current_process->pid);
+            Exit(ERROR);
+         }
+         memcpy(ctx, &current_process->user_context, sizeof(UserContext));
+         return;
+      }
+   }
    if (ctx->code == YALNIX_MAPERR &&
       fault_addr > user_heap_limit_addr &&
       fault_addr < user_stack_base_addr
@@ -213,8 +108,21 @@ void MemoryTrapHandler(UserContext* ctx) {
          TracePrintf(0, "Kernel: Memory trap handler killing process PID %d because of a failure at growing user stack!\n", current_process->pid);
          Exit(ERROR);
       }
+      memcpy(ctx, &current_process->user_context, sizeof(UserContext));
       return;
    }
+   // A write to a page shared copy-on-write by Fork: give the writer its own copy and retry
+   if (ctx->code == YALNIX_ACCERR && fault_addr >= VMEM_1_BASE && fault_addr < VMEM_1_LIMIT) {
+      int fault_vpn = (DOWN_TO_PAGE(fault_addr) - VMEM_1_BASE) >> PAGESHIFT;
+      if (current_process->page_flags[fault_vpn] & PAGE_COW) {
+         if (BreakCOW(current_process, fault_vpn) == ERROR) {
+            TracePrintf(0, "Kernel: Memory trap handler killing process PID %d because it could not copy a copy-on-write page!\n", current_process->pid);
+            Exit(ERROR);
+         }
+         memcpy(ctx, &current_process->user_context, sizeof(UserContext));
+         return;
+      }
+   }
    if (ctx -> code == YALNIX_MAPERR)
    if (ctx->code == YALNIX_MAPERR) {
       TracePrintf(0, "Kernel: Error, page is not mapped!\n");
@@ -266,93 +174,68 @@ void TtyTrapTransmitHandler(UserContext* ctx) {
       PCB *finished_writer = terminal->current_writer;
       terminal->current_writer = NULL;
 
+      PCB *woken_writer = NULL;
       if (finished_writer != NULL) {
          TracePrintf(0, "Trap: Waking finished writer PID %d.\n", finished_writer->pid);
-         finished_writer->state = PROC_READY;
          finished_writer->user_context.regs[0] = bytes_written; // Set return value
-         queueRemove(blocked_queue, finished_writer);
-         queueEnqueue(ready_queue, finished_writer);
+         woken_writer = WaitQueueWakeOne(&terminal->write_done);
       }
 
-      // Now, we need to wake any other writers if they is any waiting processes
-      if (!is_empty(terminal->blocked_writers)) {
-         TracePrintf(0, "Trap: Waking next blocked writer for terminal %d.\n", tty_id);
-         PCB *next_writer = queueDequeue(terminal->blocked_writers);
-         
-         // Let's wake this process
-         next_writer->state = PROC_READY;
-         queueRemove(blocked_queue, next_writer);
-         queueEnqueue(ready_queue, next_writer);
-
+      // Now, hand the terminal straight to the next waiting writer if there is one
+      if (WaitQueueWakeOne(&terminal->blocked_writers) != NULL) {
+         TracePrintf(0, "Trap: Woke next blocked writer for terminal %d.\n", tty_id);
       } else {
          TracePrintf(0, "Trap: Terminal %d is now free.\n", tty_id);
          terminal->in_use = 0;
       }
+
+      // Run the finished writer now rather than after everything already on the ready queue
+      if (woken_writer != NULL) {
+         memcpy(&current_process->user_context, ctx, sizeof(UserContext));
+         WaitQueueHandoff(woken_writer);
+         memcpy(ctx, &current_process->user_context, sizeof(UserContext));
+      }
    }
 }
 
+// Lines come in from the hardware here before going into the terminal's input ring
+static char receive_line[TERMINAL_MAX_LINE];
+
 void TtyTrapReceiveHandler(UserContext* ctx) {
    int tty_id = ctx->code;
    terminal_t *terminal = &terminals[tty_id];
 
-   int len = TtyReceive(tty_id, terminal->read_buffer + terminal->read_buffer_len, TERMINAL_MAX_LINE - terminal->read_buffer_len);
-   terminal->read_buffer_len += len;
+   int len = TtyReceive(tty_id, receive_line, TERMINAL_MAX_LINE);
+   TtyInputAppend(terminal, receive_line, len);
 
-   TracePrintf(0, "TtyTrapReceiveHandler: Terminal tty_id %d now has %d bytes available for reading.\n", terminal->tty_id, terminal->read_buffer_len);
+   TracePrintf(0, "TtyTrapReceiveHandler: Terminal tty_id %d now has %d bytes available for reading.\n", terminal->tty_id, TtyInputAvailable(terminal));
    TracePrintf(0, "TtyTrapReceiveHandler: Checking if there are any processes waiting to read from terminal tty_id %d...\n", terminal->tty_id);
 
-   while (!is_empty(terminal->blocked_readers) && terminal->read_buffer_len > 0) {
-      PCB *reader = queueDequeue(terminal->blocked_readers);
-      int bytes_to_read = (reader->tty_read_len < terminal->read_buffer_len) ? reader->tty_read_len : terminal->read_buffer_len;
+   PCB *first_reader = NULL;
+   while (!WaitQueueIsEmpty(&terminal->blocked_readers) && TtyInputAvailable(terminal) > 0) {
+      PCB *reader = WaitQueueWakeOne(&terminal->blocked_readers);
+      if (first_reader == NULL) {
+         first_reader = reader;
+      }
+      int bytes_to_read = (reader->tty_read_len < TtyInputAvailable(terminal)) ? reader->tty_read_len : TtyInputAvailable(terminal);
       TracePrintf(0, "TtyTrapReceiveHandler: Process PID %d has woken up to read %d bytes!\n", reader->pid, bytes_to_read);
 
-      char *kernel_buffer = malloc(bytes_to_read);
-      if (kernel_buffer != NULL) {
-         memcpy(kernel_buffer, terminal->read_buffer, bytes_to_read);
-         reader->tty_kernel_read_buf = kernel_buffer;
-         reader->kernel_read_size = bytes_to_read;
-         reader->user_context.regs[0] = bytes_to_read;
-      } else {
-         // In case the allocation failed. Was thinking of killing that process but no need for that
-         reader->user_context.regs[0] = 0;
-         bytes_to_read = 0;
-      }
-      // Set return value to number of bytes read
+      // Straight into the reader's buffer if it is resident. Otherwise the data stays in the ring and
+      // the reader, woken with 0, pages its buffer in and copies it itself
+      bytes_to_read = TtyInputDeliver(terminal, reader, bytes_to_read);
+      reader->user_context.regs[0] = bytes_to_read; // Set return value to number of bytes read
       TracePrintf(0, "TtyTrapReceiveHandler: Process PID %d read %d bytes from terminal tty_id %d.\n", reader->pid, bytes_to_read, terminal->tty_id);
-      
-      // Shift terminal buffer
-      if (bytes_to_read > 0) {
-         if (bytes_to_read < terminal->read_buffer_len) {
-            memmove(terminal->read_buffer, terminal->read_buffer + bytes_to_read, terminal->read_buffer_len - bytes_to_read);
-            terminal->read_buffer_len -= bytes_to_read;
-         } else {
-            // In case we read the whole data on the terminal
-            terminal->read_buffer_len = 0;
-         }
-      }
-
-      // Remove the reader from the blocked queue
-      queueRemove(blocked_queue, reader);
-
-      // Now put back this process into ready queue
-      reader->state = PROC_READY;
-      queueEnqueue(ready_queue, reader);
    }
-}
-
 
-void trapHandlerHelper(void *arg, PCB *process) {
-   if (process->delay_ticks > 0) {
-      process->delay_ticks--;
-      if (process->delay_ticks == 0) {
-            TracePrintf(0, "Process PID %d delay has elapsed!\n", process->pid);
-            queueRemove(blocked_queue, process);
-            process->state = PROC_READY;
-            queueEnqueue(ready_queue, process);
-         }
+   // The first reader runs right away; any others wait their turn on the ready queue
+   if (first_reader != NULL) {
+      memcpy(&current_process->user_context, ctx, sizeof(UserContext));
+      WaitQueueHandoff(first_reader);
+      memcpy(ctx, &current_process->user_context, sizeof(UserContext));
    }
 }
 
+
 int growStack(unsigned int addr) {
    unsigned int addr_aligned_to_page_base = DOWN_TO_PAGE(addr);
    unsigned int stack_base_aligned_to_page_base = DOWN_TO_PAGE((unsigned int)(current_process->user_stack_base_vaddr));
@@ -362,8 +245,15 @@ int growStack(unsigned int addr) {
    int num_pages_requested = stack_base_vpn - target_vpn;
 
    pte_t *pt_region1 = current_process->ptbr;
+   // The stack may not grow through a Shared_Pages mapping
+   for (int i = 0; i < num_pages_requested; i++) {
+      if (current_process->page_flags[target_vpn + i] & PAGE_SHARED) {
+         TracePrintf(0, "Kernel: Stack of process PID %d ran into its shared pages!\n", current_process->pid);
+         return KILL;
+      }
+   }
    for (int i = 0; i < num_pages_requested; i++) {
-      int pfn = allocFrame(FRAME_USER, current_process->pid);
+      int pfn = allocZeroedFrame(FRAME_USER, current_process->pid);
       if (pfn == -1) {
          TracePrintf(0, "Kernel: Ran out of physical frames while trying to grow user stack for process PID %d!\n", current_process->pid);
          // Need to deallocate all the frames that we already allocated
@@ -371,7 +261,6 @@ int growStack(unsigned int addr) {
             int pfn_to_free = pt_region1[target_vpn + j].pfn;
             freeFrame(pfn_to_free);
             pt_region1[target_vpn + j].valid = 0;
-            // Do i need to zero out the frame?
          }
          return KILL;
       }
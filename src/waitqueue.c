@@ -0,0 +1,62 @@
+#include "waitqueue.h"
+#include "proc.h"
+#include "sched.h"
+#include "kernel.h"
+#include <ykernel.h>
+
+void WaitQueueInit(wait_queue_t *wq, char *name) {
+    procListInit(&wq->sleepers);
+    wq->name = name;
+}
+
+void WaitQueueSleep(wait_queue_t *wq) {
+    PCB *curr = current_process;
+    curr->state = PROC_BLOCKED;
+    procListEnqueue(&wq->sleepers, curr);
+    TracePrintf(1, "WaitQueueSleep: Process PID %d sleeping on %s\n", curr->pid, wq->name);
+
+    PCB *next = SchedPickNext();
+    if (KernelContextSwitch(KCSwitch, curr, next) == -1) {
+        TracePrintf(0, "WaitQueueSleep: Failed to switch away from process PID %d!\n", curr->pid);
+        Halt();
+    }
+}
+
+PCB *WaitQueueWakeOne(wait_queue_t *wq) {
+    PCB *proc = procListDequeue(&wq->sleepers);
+    if (proc != NULL) {
+        TracePrintf(1, "WaitQueueWakeOne: Waking process PID %d from %s\n", proc->pid, wq->name);
+        SchedWake(proc);
+    }
+    return proc;
+}
+
+int WaitQueueWakeAll(wait_queue_t *wq) {
+    int woken = 0;
+    while (WaitQueueWakeOne(wq) != NULL) {
+        woken++;
+    }
+    return woken;
+}
+
+void WaitQueueWake(PCB *proc) {
+    procListRemove(proc);
+    SchedWake(proc);
+}
+
+void WaitQueueHandoff(PCB *wakee) {
+    PCB *curr = current_process;
+    if (wakee == NULL || wakee == curr || wakee->state != PROC_READY || !SchedCanHandoff(curr, wakee)) {
+        return;
+    }
+    TracePrintf(1, "WaitQueueHandoff: Process PID %d hands the CPU to PID %d\n", curr->pid, wakee->pid);
+    SchedHandoff(curr, wakee);
+    if (KernelContextSwitch(KCSwitch, curr, wakee) == -1) {
+        TracePrintf(0, "WaitQueueHandoff: Failed to switch to process PID %d!\n", wakee->pid);
+        Halt();
+    }
+}
+
+int WaitQueueIsEmpty(wait_queue_t *wq) {
+    return procListIsEmpty(&wq->sleepers);
+}
@@ -0,0 +1,59 @@
+#include <hardware.h>
+#include <yuser.h>
+#include "syscalls/custom.h"
+
+/**
+ * Description: Dumps the kernel's per-syscall counters (KERNEL_OP_STATS) to terminal 0.
+ * With no argument it prints the system-wide table followed by the memory counters
+ * (KERNEL_OP_MEM_STATS); "self" prints this process's own syscall table only.
+ * Run it at the end of a workload, e.g. Exec'd from the workload's parent.
+*/
+static char *stat_names[SYSCALL_STAT_SLOTS] = {
+    [SYSCALL_STAT_FORK] = "Fork",
+    [SYSCALL_STAT_EXEC] = "Exec",
+    [SYSCALL_STAT_EXIT] = "Exit",
+    [SYSCALL_STAT_WAIT] = "Wait",
+    [SYSCALL_STAT_GETPID] = "GetPid",
+    [SYSCALL_STAT_BRK] = "Brk",
+    [SYSCALL_STAT_DELAY] = "Delay",
+    [SYSCALL_STAT_TTY_READ] = "TtyRead",
+    [SYSCALL_STAT_TTY_WRITE] = "TtyWrite",
+    [SYSCALL_STAT_SHARED_PAGES] = "Shared_Pages",
+    [SYSCALL_STAT_WAITPID] = "WaitPid",
+    [SYSCALL_STAT_SCHED_CONTROL] = "SchedControl",
+    [SYSCALL_STAT_KERNEL_OP] = "KernelOp",
+};
+
+int main(int argc, char** argv) {
+    int pid = -1;
+    if (argc > 1 && argv[1][0] == 's') { // "self"
+        pid = 0;
+    }
+
+    syscall_stat_t stats[SYSCALL_STAT_SLOTS];
+    int nslots = SyscallStats(pid, stats, SYSCALL_STAT_SLOTS);
+    if (nslots == ERROR) {
+        TtyPrintf(0, "syscall_stats: KERNEL_OP_STATS failed\n");
+        Exit(ERROR);
+    }
+
+    TtyPrintf(0, "syscall: calls errors blocked ticks max\n");
+    for (int i = 0; i < SYSCALL_STAT_SLOTS && i < nslots; i++) {
+        if (stats[i].calls == 0) {
+            continue;
+        }
+        TtyPrintf(0, "%s: %d %d %d %d %d\n", stat_names[i], stats[i].calls, stats[i].errors,
+                  stats[i].blocked, stats[i].total_ticks, stats[i].max_ticks);
+    }
+
+    if (pid == -1) {
+        mem_stat_t mem;
+        if (MemStats(&mem) == ERROR) {
+            TtyPrintf(0, "syscall_stats: KERNEL_OP_MEM_STATS failed\n");
+            Exit(ERROR);
+        }
+        TtyPrintf(0, "frames: %d free, %d zeroed\n", mem.free_frames, mem.zeroed_frames);
+        TtyPrintf(0, "zero pool: %d hits, %d misses\n", mem.zero_pool_hits, mem.zero_pool_misses);
+    }
+    return 0;
+}
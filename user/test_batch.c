@@ -0,0 +1,36 @@
+#include <hardware.h>
+#include <yalnix.h>
+#include <yuser.h>
+#include "syscalls/custom.h"
+
+/**
+ * Description: Tests KERNEL_OP_BATCH. Several GetPid calls, a Brk and a TtyWrite go in with
+ * one trap; the batch has to stop after the TtyWrite and leave the last GetPid unrun.
+*/
+int main(int argc, char** argv) {
+    static char msg[] = "Hello from a syscall batch\n";
+    char *heap = malloc(16);
+    syscall_desc_t descs[6];
+
+    for (int i = 0; i < 6; i++) {
+        descs[i].code = YALNIX_GETPID;
+        descs[i].result = -42;
+    }
+    descs[2].code = YALNIX_BRK;
+    descs[2].args[0] = (int)(heap + 0x4000);
+    descs[4].code = YALNIX_TTY_WRITE;
+    descs[4].args[0] = 0;
+    descs[4].args[1] = (int)msg;
+    descs[4].args[2] = sizeof(msg) - 1;
+
+    int ran = SyscallBatch(descs, 6);
+    TracePrintf(0, "Batch ran %d entries (expected 5)\n", ran);
+    TracePrintf(0, "GetPid results %d %d %d (expected %d)\n", descs[0].result, descs[1].result, descs[3].result, GetPid());
+    TracePrintf(0, "Brk %d, TtyWrite %d (expected 0 %d), last entry %d (expected -42)\n",
+                descs[2].result, descs[4].result, (int)sizeof(msg) - 1, descs[5].result);
+
+    descs[0].code = YALNIX_FORK;
+    TracePrintf(0, "Batch with Fork ran %d entries, result %d (expected 1 and ERROR)\n", SyscallBatch(descs, 1), descs[0].result);
+    TracePrintf(0, "Oversized batch returned %d (expected ERROR)\n", SyscallBatch(descs, SYSCALL_BATCH_MAX + 1));
+    return 0;
+}
@@ -0,0 +1,33 @@
+#include <hardware.h>
+#include <yuser.h>
+
+/**
+ * Description: Tests copy-on-write Fork. Parent and child both write to the same
+ * global, heap and stack pages after Fork and must each keep seeing their own values.
+*/
+int global_value = 1;
+
+int main(int argc, char** argv) {
+    int *heap_value = malloc(sizeof(int));
+    int stack_value = 3;
+    *heap_value = 2;
+
+    int pid = Fork();
+    if (pid == 0) {
+        global_value = 10;
+        *heap_value = 20;
+        stack_value = 30;
+        Delay(2);
+        TracePrintf(0, "Child: global %d heap %d stack %d (expected 10 20 30)\n", global_value, *heap_value, stack_value);
+        Exit(0);
+    }
+
+    Delay(1);
+    TracePrintf(0, "Parent: global %d heap %d stack %d (expected 1 2 3)\n", global_value, *heap_value, stack_value);
+    global_value = 100;
+
+    int status;
+    Wait(&status);
+    TracePrintf(0, "Parent: global %d after child exited with status %d (expected 100 0)\n", global_value, status);
+    return 0;
+}
@@ -0,0 +1,42 @@
+#include <hardware.h>
+#include <yuser.h>
+
+/**
+ * Description: Tests that Exit gives back a process's memory, kernel stack and process table
+ * slot. Forks far more children than MAX_PROCS (each touching some heap), one after another,
+ * and finally leaves a few orphans behind for the reaper. Runs out of frames or pids otherwise.
+*/
+#define ROUNDS 400 // comfortably more than MAX_PROCS
+
+int main(int argc, char** argv) {
+    for (int i = 0; i < ROUNDS; i++) {
+        int pid = Fork();
+        if (pid == 0) {
+            char *buf = malloc(8 * PAGESIZE);
+            buf[0] = buf[8 * PAGESIZE - 1] = (char)i;
+            Exit(i);
+        }
+        int status;
+        Wait(&status);
+        if (status != i) {
+            TracePrintf(0, "Round %d: child exited with %d\n", i, status);
+        }
+    }
+    TracePrintf(0, "Reaped %d children\n", ROUNDS);
+
+    // Grandchildren that outlive their parent are reaped without anyone calling Wait
+    if (Fork() == 0) {
+        for (int i = 0; i < 4; i++) {
+            if (Fork() == 0) {
+                Delay(2);
+                Exit(0);
+            }
+        }
+        Exit(0);
+    }
+    int status;
+    Wait(&status);
+    Delay(5);
+    TracePrintf(0, "Orphans done\n");
+    return 0;
+}
@@ -0,0 +1,32 @@
+#include <hardware.h>
+#include <yuser.h>
+#include "syscalls/custom.h"
+
+/**
+ * Description: Tests SetQuantum. A CPU-bound child is given a long time slice while the
+ * parent keeps printing; both should make progress, and bad requests must fail.
+*/
+int main(int argc, char** argv) {
+    int old = SetQuantum(0, 2);
+    TracePrintf(0, "Own quantum was %d, now 2\n", old);
+    TracePrintf(0, "SetQuantum(0, -1) returned %d (expected ERROR)\n", SetQuantum(0, -1));
+
+    int pid = Fork();
+    if (pid == 0) {
+        volatile int spin = 0;
+        for (int i = 0; i < 2000000; i++) {
+            spin++;
+        }
+        Exit(0);
+    }
+    TracePrintf(0, "Child quantum was %d, now 8\n", SetQuantum(pid, 8));
+    TracePrintf(0, "SetQuantum(%d, 4) on a non-child returned %d (expected ERROR)\n", pid + 1000, SetQuantum(pid + 1000, 4));
+
+    for (int i = 0; i < 5; i++) {
+        TracePrintf(0, "Parent still gets the CPU (%d)\n", i);
+        Delay(1);
+    }
+    int status;
+    Wait(&status);
+    return 0;
+}
@@ -0,0 +1,33 @@
+#include <hardware.h>
+#include <yuser.h>
+
+/**
+ * Description: Tests Shared_Pages. The parent maps two shared pages and forks; the child
+ * writes into them and the parent must see the child's data without any copying.
+*/
+int main(int argc, char** argv) {
+    int *shared = (int *)Shared_Pages(2);
+    if (shared == 0) {
+        TracePrintf(0, "Shared_Pages failed\n");
+        Exit(-1);
+    }
+    int last = (2 * PAGESIZE) / sizeof(int) - 1;
+    shared[0] = 1;
+
+    int pid = Fork();
+    if (pid == 0) {
+        TracePrintf(0, "Child: shared[0] is %d (expected 1)\n", shared[0]);
+        shared[0] = 42;
+        shared[last] = 43;
+        Exit(0);
+    }
+
+    int status;
+    Wait(&status);
+    TracePrintf(0, "Parent: shared[0] %d shared[last] %d (expected 42 43)\n", shared[0], shared[last]);
+
+    // Heap growth must still work with the shared mapping in place
+    char *buf = malloc(4 * PAGESIZE);
+    TracePrintf(0, "Parent: malloc after Shared_Pages returned %p\n", buf);
+    return 0;
+}
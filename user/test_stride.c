@@ -0,0 +1,43 @@
+#include <hardware.h>
+#include <yuser.h>
+#include "syscalls/custom.h"
+
+/**
+ * Description: Tests stride scheduling; boot with sched=stride. Two CPU-bound children hold
+ * 300 and 100 tickets, so while both are running the first should get about three times the
+ * ticks of the second.
+*/
+#define SPIN_TICKS 60
+
+static void spin(void) {
+    volatile int spin = 0;
+    while (GetTicks(0) < SPIN_TICKS) {
+        spin++;
+    }
+    Exit(0);
+}
+
+int main(int argc, char** argv) {
+    TracePrintf(0, "SetShare(0, %d) returned %d (expected ERROR)\n", 5000, SetShare(0, 5000));
+
+    int heavy = Fork();
+    if (heavy == 0) {
+        spin();
+    }
+    int light = Fork();
+    if (light == 0) {
+        spin();
+    }
+    SetShare(heavy, 300);
+    SetShare(light, 100);
+
+    Delay(40);
+    int heavy_ticks = GetTicks(heavy);
+    int light_ticks = GetTicks(light);
+    TracePrintf(0, "After 40 ticks: heavy ran %d, light ran %d (expected about 3:1)\n", heavy_ticks, light_ticks);
+
+    int status;
+    Wait(&status);
+    Wait(&status);
+    return 0;
+}
@@ -0,0 +1,35 @@
+#include <hardware.h>
+#include <yuser.h>
+#include "syscalls/custom.h"
+
+/**
+ * Description: Tests WaitPid. The parent polls with WAIT_NOHANG while its children are still
+ * running, then reaps the slow child by pid before the fast one, checks that a bad status
+ * pointer fails without reaping anything, and finally reaps the rest.
+*/
+int main(int argc, char** argv) {
+    int fast = Fork();
+    if (fast == 0) {
+        Exit(1);
+    }
+    int slow = Fork();
+    if (slow == 0) {
+        Delay(5);
+        Exit(2);
+    }
+
+    int status = -1;
+    TracePrintf(0, "WaitPid(slow, NOHANG) returned %d (expected 0)\n", WaitPid(slow, &status, WAIT_NOHANG));
+    TracePrintf(0, "WaitPid(%d) returned %d (expected ERROR, not a child)\n", slow + 1000, WaitPid(slow + 1000, &status, 0));
+
+    int pid = WaitPid(slow, &status, 0);
+    TracePrintf(0, "Reaped %d with status %d (expected %d 2)\n", pid, status, slow);
+
+    TracePrintf(0, "WaitPid with a bad status pointer returned %d (expected ERROR)\n", WaitPid(-1, (int *)0x10, WAIT_NOHANG));
+
+    pid = WaitPid(-1, &status, WAIT_NOHANG);
+    TracePrintf(0, "Reaped %d with status %d (expected %d 1)\n", pid, status, fast);
+
+    TracePrintf(0, "Wait with no children returned %d (expected ERROR)\n", Wait(&status));
+    return 0;
+}